@@ -191,6 +191,34 @@ namespace fs
 		// Do notning
 	}
 
+	u64 file_base::read_at(u64 offset, void* buffer, u64 size)
+	{
+		const u64 old_pos = seek(0, seek_cur);
+
+		if (seek(offset, seek_set) != offset)
+		{
+			return 0;
+		}
+
+		const u64 result = read(buffer, size);
+		seek(old_pos, seek_set);
+		return result;
+	}
+
+	u64 file_base::write_at(u64 offset, const void* buffer, u64 size)
+	{
+		const u64 old_pos = seek(0, seek_cur);
+
+		if (seek(offset, seek_set) != offset)
+		{
+			return 0;
+		}
+
+		const u64 result = write(buffer, size);
+		seek(old_pos, seek_set);
+		return result;
+	}
+
 	dir_base::~dir_base()
 	{
 	}
@@ -900,6 +928,40 @@ fs::file::file(const std::string& path, bs_t<open_mode> mode)
 			return nwritten;
 		}
 
+		u64 read_at(u64 offset, void* buffer, u64 count) override
+		{
+			// Note: synchronous handle still moves the file pointer
+			const int size = narrow<int>(count, "file::read_at" HERE);
+
+			OVERLAPPED ovl{};
+			ovl.Offset = static_cast<DWORD>(offset);
+			ovl.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+			DWORD nread;
+
+			if (!ReadFile(m_handle, buffer, size, &nread, &ovl))
+			{
+				verify("file::read_at" HERE), GetLastError() == ERROR_HANDLE_EOF;
+				return 0;
+			}
+
+			return nread;
+		}
+
+		u64 write_at(u64 offset, const void* buffer, u64 count) override
+		{
+			const int size = narrow<int>(count, "file::write_at" HERE);
+
+			OVERLAPPED ovl{};
+			ovl.Offset = static_cast<DWORD>(offset);
+			ovl.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+			DWORD nwritten;
+			verify("file::write_at" HERE), WriteFile(m_handle, buffer, size, &nwritten, &ovl);
+
+			return nwritten;
+		}
+
 		u64 seek(s64 offset, seek_mode whence) override
 		{
 			LARGE_INTEGER pos;
@@ -1025,6 +1087,22 @@ fs::file::file(const std::string& path, bs_t<open_mode> mode)
 			return result;
 		}
 
+		u64 read_at(u64 offset, void* buffer, u64 count) override
+		{
+			const auto result = ::pread(m_fd, buffer, count, offset);
+			verify("file::read_at" HERE), result != -1;
+
+			return result;
+		}
+
+		u64 write_at(u64 offset, const void* buffer, u64 count) override
+		{
+			const auto result = ::pwrite(m_fd, buffer, count, offset);
+			verify("file::write_at" HERE), result != -1;
+
+			return result;
+		}
+
 		u64 seek(s64 offset, seek_mode whence) override
 		{
 			const int mode =
@@ -1085,13 +1163,24 @@ fs::file::file(const void* ptr, std::size_t size)
 
 		u64 read(void* buffer, u64 count) override
 		{
-			if (m_pos < m_size)
+			const u64 result = read_at(m_pos, buffer, count);
+			m_pos += result;
+			return result;
+		}
+
+		u64 write(const void* buffer, u64 count) override
+		{
+			return 0;
+		}
+
+		u64 read_at(u64 offset, void* buffer, u64 count) override
+		{
+			if (offset < m_size)
 			{
 				// Get readable size
-				if (const u64 result = std::min<u64>(count, m_size - m_pos))
+				if (const u64 result = std::min<u64>(count, m_size - offset))
 				{
-					std::memcpy(buffer, m_ptr + m_pos, result);
-					m_pos += result;
+					std::memcpy(buffer, m_ptr + offset, result);
 					return result;
 				}
 			}
@@ -1099,7 +1188,7 @@ fs::file::file(const void* ptr, std::size_t size)
 			return 0;
 		}
 
-		u64 write(const void* buffer, u64 count) override
+		u64 write_at(u64 offset, const void* buffer, u64 count) override
 		{
 			return 0;
 		}
@@ -1131,6 +1220,203 @@ fs::file::file(const void* ptr, std::size_t size)
 	m_file = std::make_unique<memory_stream>(ptr, size);
 }
 
+bool fs::file::map_readonly()
+{
+	const auto getter = dynamic_cast<get_native_handle*>(m_file.get());
+
+	if (!getter)
+	{
+		g_tls_error = fs::error::inval;
+		return false;
+	}
+
+	const u64 size = m_file->size();
+
+	if (!size || size != static_cast<std::size_t>(size))
+	{
+		g_tls_error = fs::error::inval;
+		return false;
+	}
+
+	class mapped_file final : public file_base, public get_native_handle
+	{
+		const std::unique_ptr<file_base> m_file; // Original file
+		const u8* const m_ptr;
+		const u64 m_size;
+#ifdef _WIN32
+		const HANDLE m_map;
+#endif
+		u64 m_pos{};
+
+		// Read-ahead state (sequential access detection)
+		atomic_t<u64> m_next{0}; // Expected offset of the next read
+		atomic_t<u64> m_window{0}; // Current read-ahead size
+		atomic_t<u64> m_advised{0}; // End of the range already advised
+
+		void read_ahead(u64 offset, u64 count)
+		{
+			if (m_next.exchange(offset + count) != offset)
+			{
+				// Random access: reset the window
+				m_window = 0;
+				return;
+			}
+
+			const u64 window = m_window = std::min<u64>(std::max<u64>(m_window * 2, 0x40000), 0x800000);
+			const u64 start = std::max<u64>(offset + count, m_advised) & ~u64{4095};
+			const u64 end = std::min<u64>(offset + count + window, m_size);
+
+			if (start < end)
+			{
+				m_advised = end;
+#ifndef _WIN32
+				::madvise(const_cast<u8*>(m_ptr) + start, end - start, MADV_WILLNEED);
+#endif
+			}
+		}
+
+	public:
+#ifdef _WIN32
+		mapped_file(std::unique_ptr<file_base>&& file, const void* ptr, u64 size, HANDLE map)
+			: m_file(std::move(file))
+			, m_ptr(static_cast<const u8*>(ptr))
+			, m_size(size)
+			, m_map(map)
+		{
+		}
+
+		~mapped_file() override
+		{
+			UnmapViewOfFile(m_ptr);
+			CloseHandle(m_map);
+		}
+#else
+		mapped_file(std::unique_ptr<file_base>&& file, const void* ptr, u64 size)
+			: m_file(std::move(file))
+			, m_ptr(static_cast<const u8*>(ptr))
+			, m_size(size)
+		{
+		}
+
+		~mapped_file() override
+		{
+			::munmap(const_cast<u8*>(m_ptr), m_size);
+		}
+#endif
+
+		stat_t stat() override
+		{
+			return m_file->stat();
+		}
+
+		bool trunc(u64 length) override
+		{
+			return false;
+		}
+
+		u64 read(void* buffer, u64 count) override
+		{
+			const u64 result = read_at(m_pos, buffer, count);
+			m_pos += result;
+			return result;
+		}
+
+		u64 write(const void* buffer, u64 count) override
+		{
+			return 0;
+		}
+
+		u64 read_at(u64 offset, void* buffer, u64 count) override
+		{
+			// The file may be changed through another descriptor: pages of truncated data fault (SIGBUS), appended data isn't mapped
+			if (m_file->size() != m_size)
+			{
+				return m_file->read_at(offset, buffer, count);
+			}
+
+			if (offset < m_size)
+			{
+				if (const u64 result = std::min<u64>(count, m_size - offset))
+				{
+					read_ahead(offset, result);
+					std::memcpy(buffer, m_ptr + offset, result);
+					return result;
+				}
+			}
+
+			return 0;
+		}
+
+		u64 write_at(u64 offset, const void* buffer, u64 count) override
+		{
+			return 0;
+		}
+
+		u64 seek(s64 offset, fs::seek_mode whence) override
+		{
+			const s64 new_pos =
+				whence == fs::seek_set ? offset :
+				whence == fs::seek_cur ? offset + m_pos :
+				whence == fs::seek_end ? offset + size() :
+				(fmt::raw_error("fs::file::mapped_file::seek(): invalid whence"), 0);
+
+			if (new_pos < 0)
+			{
+				fs::g_tls_error = fs::error::inval;
+				return -1;
+			}
+
+			m_pos = new_pos;
+			return m_pos;
+		}
+
+		u64 size() override
+		{
+			return m_file->size();
+		}
+
+		native_handle get() override
+		{
+			return dynamic_cast<get_native_handle&>(*m_file).get();
+		}
+	};
+
+	const u64 pos = m_file->seek(0, seek_cur);
+
+#ifdef _WIN32
+	const HANDLE map = CreateFileMappingW(getter->get(), 0, PAGE_READONLY, 0, 0, 0);
+	const auto ptr = map ? MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+	if (!ptr)
+	{
+		g_tls_error = to_error(GetLastError());
+
+		if (map)
+		{
+			CloseHandle(map);
+		}
+
+		return false;
+	}
+
+	auto result = std::make_unique<mapped_file>(std::move(m_file), ptr, size, map);
+#else
+	const auto ptr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, getter->get(), 0);
+
+	if (ptr == MAP_FAILED)
+	{
+		g_tls_error = to_error(errno);
+		return false;
+	}
+
+	auto result = std::make_unique<mapped_file>(std::move(m_file), ptr, size);
+#endif
+
+	result->seek(pos, seek_set);
+	m_file = std::move(result);
+	return true;
+}
+
 fs::native_handle fs::file::get_handle() const
 {
 	if (auto getter = dynamic_cast<get_native_handle*>(m_file.get()))
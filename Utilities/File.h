@@ -81,6 +81,10 @@ namespace fs
 		virtual u64 write(const void* buffer, u64 size) = 0;
 		virtual u64 seek(s64 offset, seek_mode whence) = 0;
 		virtual u64 size() = 0;
+
+		// Positional access (default implementation uses seek and restores the position, not thread-safe)
+		virtual u64 read_at(u64 offset, void* buffer, u64 size);
+		virtual u64 write_at(u64 offset, const void* buffer, u64 size);
 	};
 
 	// Directory entry (TODO)
@@ -190,6 +194,10 @@ namespace fs
 		// Open memory for read
 		explicit file(const void* ptr, std::size_t size);
 
+		// Replace the opened native file with its read-only memory mapping (the file is unchanged on failure).
+		// Reads fall back to the file if its size changes, but I/O errors fault: only map files on read-only media.
+		bool map_readonly();
+
 		// Open file with specified args (forward to constructor)
 		template <typename... Args>
 		bool open(Args&&... args)
@@ -255,6 +263,20 @@ namespace fs
 			return m_file->write(buffer, count);
 		}
 
+		// Read the data at the specified offset without changing current position
+		u64 read_at(u64 offset, void* buffer, u64 count) const
+		{
+			if (!m_file) xnull();
+			return m_file->read_at(offset, buffer, count);
+		}
+
+		// Write the data at the specified offset without changing current position
+		u64 write_at(u64 offset, const void* buffer, u64 count) const
+		{
+			if (!m_file) xnull();
+			return m_file->write_at(offset, buffer, count);
+		}
+
 		// Change current position, returns resulting position
 		u64 seek(s64 offset, seek_mode whence = seek_set) const
 		{
@@ -534,16 +556,29 @@ namespace fs
 		}
 
 		u64 read(void* buffer, u64 size) override
+		{
+			const u64 result = read_at(pos, buffer, size);
+			pos += result;
+			return result;
+		}
+
+		u64 write(const void* buffer, u64 size) override
+		{
+			const u64 result = write_at(pos, buffer, size);
+			pos += result;
+			return result;
+		}
+
+		u64 read_at(u64 offset, void* buffer, u64 size) override
 		{
 			const u64 end = obj.size();
 
-			if (pos < end)
+			if (offset < end)
 			{
 				// Get readable size
-				if (const u64 max = std::min<u64>(size, end - pos))
+				if (const u64 max = std::min<u64>(size, end - offset))
 				{
-					std::copy(obj.cbegin() + pos, obj.cbegin() + pos + max, static_cast<value_type*>(buffer));
-					pos = pos + max;
+					std::copy(obj.cbegin() + offset, obj.cbegin() + offset + max, static_cast<value_type*>(buffer));
 					return max;
 				}
 			}
@@ -551,7 +586,7 @@ namespace fs
 			return 0;
 		}
 
-		u64 write(const void* buffer, u64 size) override
+		u64 write_at(u64 offset, const void* buffer, u64 size) override
 		{
 			const u64 old_size = obj.size();
 
@@ -560,21 +595,20 @@ namespace fs
 				fmt::raw_error("fs::container_stream<>::write(): overflow");
 			}
 
-			if (pos > old_size)
+			if (offset > old_size)
 			{
 				// Fill gap if necessary (default-initialized)
-				obj.resize(pos);
+				obj.resize(offset);
 			}
 
 			const auto src = static_cast<const value_type*>(buffer);
 
 			// Overwrite existing part
-			const u64 overlap = std::min<u64>(obj.size() - pos, size);
-			std::copy(src, src + overlap, obj.begin() + pos);
+			const u64 overlap = std::min<u64>(obj.size() - offset, size);
+			std::copy(src, src + overlap, obj.begin() + offset);
 
 			// Append new data
 			obj.insert(obj.end(), src + overlap, src + size);
-			pos += size;
 
 			return size;
 		}
@@ -1092,6 +1092,22 @@ bool handle_access_violation(u32 addr, bool is_writing, x64_context* context)
 	{
 		g_tls_fault_rsx++;
 
+		if (is_writing)
+		{
+			// The page may be tracked as well and its protection is gone now
+			vm::dirty_fault(addr);
+		}
+
+		if (cpu)
+		{
+			cpu->test_state();
+		}
+
+		return true;
+	}
+
+	if (is_writing && vm::dirty_fault(addr))
+	{
 		if (cpu)
 		{
 			cpu->test_state();
@@ -1551,7 +1567,27 @@ extern thread_local std::string(*g_tls_log_prefix)();
 
 DECLARE(thread_ctrl::g_native_core_layout) { native_core_arrangement::undefined };
 
-void thread_ctrl::start(const std::shared_ptr<thread_ctrl>& ctrl, task_stack task)
+// Idle host threads waiting for another pooled thread_ctrl to run
+struct thread_pool
+{
+	static constexpr std::size_t max_idle = 16;
+
+	struct slot
+	{
+		std::condition_variable cond;
+
+		thread_ctrl* next = nullptr;
+	};
+
+	std::mutex mutex;
+
+	std::vector<slot*> idle;
+};
+
+// Intentionally leaked: idle host threads may outlive static destruction
+static thread_pool* const s_thread_pool = new thread_pool;
+
+void thread_ctrl::start(const std::shared_ptr<thread_ctrl>& ctrl, task_stack task, bool pooled)
 {
 #ifdef _WIN32
 	using thread_result = uint;
@@ -1564,46 +1600,125 @@ void thread_ctrl::start(const std::shared_ptr<thread_ctrl>& ctrl, task_stack tas
 	// Thread entry point
 	const thread_type entry = [](void* arg) -> thread_result
 	{
-		// Recover shared_ptr from short-circuited thread_ctrl object pointer
-		const std::shared_ptr<thread_ctrl> ctrl = static_cast<thread_ctrl*>(arg)->m_self;
+		run(static_cast<thread_ctrl*>(arg));
+		return 0;
+	};
 
-		try
-		{
-			ctrl->initialize();
-			task_stack{std::move(ctrl->m_task)}.invoke();
-		}
-		catch (...)
+	// Pooled thread entry point: keep running handed over threads until idle for too long
+	const thread_type pooled_entry = [](void* arg) -> thread_result
+	{
+		thread_pool::slot slot;
+		slot.next = static_cast<thread_ctrl*>(arg);
+
+		while (true)
 		{
-			// Capture exception
-			ctrl->finalize(std::current_exception());
-			return 0;
+			run(std::exchange(slot.next, nullptr));
+
+			std::unique_lock<std::mutex> lock(s_thread_pool->mutex);
+
+			if (s_thread_pool->idle.size() >= thread_pool::max_idle)
+			{
+				break;
+			}
+
+			s_thread_pool->idle.push_back(&slot);
+
+			if (!slot.cond.wait_for(lock, std::chrono::seconds(30), [&] { return slot.next != nullptr; }))
+			{
+				s_thread_pool->idle.erase(std::find(s_thread_pool->idle.begin(), s_thread_pool->idle.end(), &slot));
+				break;
+			}
 		}
 
-		ctrl->finalize(nullptr);
 		return 0;
 	};
 
 	ctrl->m_self = ctrl;
 	ctrl->m_task = std::move(task);
 
-	// TODO: implement simple thread pool
+	if (pooled)
+	{
+		std::lock_guard<std::mutex> lock(s_thread_pool->mutex);
+
+		if (!s_thread_pool->idle.empty())
+		{
+			// Hand over to an idle host thread (m_thread remains unset)
+			const auto slot = s_thread_pool->idle.back();
+			s_thread_pool->idle.pop_back();
+			slot->next = ctrl.get();
+			slot->cond.notify_one();
+			return;
+		}
+	}
+
 #ifdef _WIN32
-	std::uintptr_t thread = _beginthreadex(nullptr, 0, entry, ctrl.get(), 0, nullptr);
+	std::uintptr_t thread = _beginthreadex(nullptr, 0, pooled ? pooled_entry : entry, ctrl.get(), 0, nullptr);
 	verify("thread_ctrl::start" HERE), thread != 0;
 #else
 	pthread_t thread;
-	verify("thread_ctrl::start" HERE), pthread_create(&thread, nullptr, entry, ctrl.get()) == 0;
+	verify("thread_ctrl::start" HERE), pthread_create(&thread, nullptr, pooled ? pooled_entry : entry, ctrl.get()) == 0;
 #endif
 
 	// TODO: this is unsafe and must be duplicated in thread_ctrl::initialize
 	ctrl->m_thread = (uintptr_t)thread;
 }
 
+// CPU time and cycles of the current host thread when the thread_ctrl started on it (the host thread may be reused)
+static thread_local u64 s_tls_start_time = 0;
+static thread_local u64 s_tls_start_cycles = 0;
+
+// Get total CPU time (ns) and cycles used by the current host thread
+static u64 get_thread_time(u64& cycles)
+{
+#ifdef _WIN32
+	ULONG64 _cycles{};
+	QueryThreadCycleTime(GetCurrentThread(), &_cycles);
+	cycles = _cycles;
+	FILETIME ctime, etime, ktime, utime;
+	GetThreadTimes(GetCurrentThread(), &ctime, &etime, &ktime, &utime);
+	return ((ktime.dwLowDateTime | (u64)ktime.dwHighDateTime << 32) + (utime.dwLowDateTime | (u64)utime.dwHighDateTime << 32)) * 100ull;
+#elif defined(RUSAGE_THREAD)
+	cycles = 0; // Not supported
+	struct ::rusage stats{};
+	::getrusage(RUSAGE_THREAD, &stats);
+	return (stats.ru_utime.tv_sec + stats.ru_stime.tv_sec) * 1000000000ull + (stats.ru_utime.tv_usec + stats.ru_stime.tv_usec) * 1000ull;
+#else
+	cycles = 0;
+	return 0;
+#endif
+}
+
+void thread_ctrl::run(thread_ctrl* _this)
+{
+	// Recover shared_ptr from short-circuited thread_ctrl object pointer
+	const std::shared_ptr<thread_ctrl> ctrl = _this->m_self;
+
+	try
+	{
+		ctrl->initialize();
+		task_stack{std::move(ctrl->m_task)}.invoke();
+	}
+	catch (...)
+	{
+		// Capture exception
+		ctrl->finalize(std::current_exception());
+		return;
+	}
+
+	ctrl->finalize(nullptr);
+}
+
 void thread_ctrl::initialize()
 {
 	// Initialize TLS variable
 	g_tls_this_thread = this;
 
+	// Reset statistics (the host thread may be reused)
+	g_tls_fault_all = 0;
+	g_tls_fault_rsx = 0;
+	g_tls_fault_spu = 0;
+	s_tls_start_time = get_thread_time(s_tls_start_cycles);
+
 	g_tls_log_prefix = []
 	{
 		return g_tls_this_thread->m_name;
@@ -1646,21 +1761,9 @@ void thread_ctrl::finalize(std::exception_ptr eptr) noexcept
 	m_task.invoke();
 	m_task.reset();
 
-#ifdef _WIN32
-	ULONG64 cycles{};
-	QueryThreadCycleTime(GetCurrentThread(), &cycles);
-	FILETIME ctime, etime, ktime, utime;
-	GetThreadTimes(GetCurrentThread(), &ctime, &etime, &ktime, &utime);
-	const u64 time = ((ktime.dwLowDateTime | (u64)ktime.dwHighDateTime << 32) + (utime.dwLowDateTime | (u64)utime.dwHighDateTime << 32)) * 100ull;
-#elif defined(RUSAGE_THREAD)
-	const u64 cycles = 0; // Not supported
-	struct ::rusage stats{};
-	::getrusage(RUSAGE_THREAD, &stats);
-	const u64 time = (stats.ru_utime.tv_sec + stats.ru_stime.tv_sec) * 1000000000ull + (stats.ru_utime.tv_usec + stats.ru_stime.tv_usec) * 1000ull;
-#else
-	const u64 cycles = 0;
-	const u64 time = 0;
-#endif
+	u64 cycles;
+	const u64 time = get_thread_time(cycles) - s_tls_start_time;
+	cycles -= s_tls_start_cycles;
 
 	g_tls_log_prefix = []
 	{
@@ -2026,7 +2129,7 @@ void named_thread::start_thread(const std::shared_ptr<void>& _this)
 	verify("named_thread::start_thread" HERE), _this.get() == this;
 
 	// Run thread
-	thread_ctrl::spawn(m_thread, get_name(), [this, _this]()
+	auto task = [this, _this]()
 	{
 		try
 		{
@@ -2042,7 +2145,16 @@ void named_thread::start_thread(const std::shared_ptr<void>& _this)
 		}
 
 		on_exit();
-	});
+	};
+
+	if (is_pooled())
+	{
+		thread_ctrl::spawn_pooled(m_thread, get_name(), std::move(task));
+	}
+	else
+	{
+		thread_ctrl::spawn(m_thread, get_name(), std::move(task));
+	}
 }
 
 task_stack::task_base::~task_base()
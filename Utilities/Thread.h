@@ -138,8 +138,11 @@ class thread_ctrl final
 	// Fixed name
 	std::string m_name;
 
-	// Start thread
-	static void start(const std::shared_ptr<thread_ctrl>&, task_stack);
+	// Start thread (optionally on an idle host thread from the pool)
+	static void start(const std::shared_ptr<thread_ctrl>&, task_stack, bool pooled = false);
+
+	// Run started thread on the current host thread
+	static void run(thread_ctrl*);
 
 	// Called at the thread start
 	void initialize();
@@ -254,6 +257,15 @@ public:
 		thread_ctrl::start(out, std::forward<F>(func));
 	}
 
+	// Named thread factory which may reuse a finished host thread (thread-local variables are not reinitialized)
+	template<typename N, typename F>
+	static inline void spawn_pooled(std::shared_ptr<thread_ctrl>& out, N&& name, F&& func)
+	{
+		out = std::make_shared<thread_ctrl>(std::forward<N>(name));
+
+		thread_ctrl::start(out, std::forward<F>(func), true);
+	}
+
 	// Detect layout
 	static void detect_cpu_layout();
 
@@ -296,6 +308,9 @@ protected:
 	// Called once upon thread spawn within the thread's own context
 	virtual void on_spawn() {}
 
+	// Whether the thread can be started on a pooled host thread
+	virtual bool is_pooled() const { return false; }
+
 public:
 	// ID initialization
 	virtual void on_init(const std::shared_ptr<void>& _this)
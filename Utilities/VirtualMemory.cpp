@@ -10,6 +10,10 @@
 #include <unistd.h>
 #include <sys/types.h>
 #endif
+#ifdef __linux__
+#include <cstdio>
+#include <cinttypes>
+#endif
 
 namespace utils
 {
@@ -85,4 +89,61 @@ namespace utils
 		verify(HERE), ::mprotect((void*)((u64)pointer & -4096), ::align(size, 4096), +prot) != -1;
 #endif
 	}
+
+	bool memory_advise_huge(void* pointer, std::size_t size)
+	{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+		// Only the given (committed) range is advised; the kernel uses huge pages for the aligned 2 MiB blocks inside it
+		const u64 start = ::align((u64)pointer, 4096);
+		const u64 end = ((u64)pointer + size) & -4096;
+		return start >= end || ::madvise((void*)start, end - start, MADV_HUGEPAGE) != -1;
+#else
+		// Windows large pages require MEM_LARGE_PAGES at allocation time and SeLockMemoryPrivilege
+		return false;
+#endif
+	}
+
+	std::size_t memory_huge_usage(void* pointer, std::size_t size, std::size_t* resident)
+	{
+		std::size_t huge = 0;
+		std::size_t rss = 0;
+
+#ifdef __linux__
+		if (std::FILE* f = std::fopen("/proc/self/smaps", "r"))
+		{
+			const u64 start = (u64)pointer;
+			const u64 end = start + size;
+
+			char line[512];
+			bool inside = false;
+
+			while (std::fgets(line, sizeof(line), f))
+			{
+				u64 from, to, kb;
+
+				if (std::sscanf(line, "%" SCNx64 "-%" SCNx64 " ", &from, &to) == 2)
+				{
+					inside = from >= start && to <= end;
+				}
+				else if (inside && std::sscanf(line, "AnonHugePages: %" SCNu64 " kB", &kb) == 1)
+				{
+					huge += kb * 1024;
+				}
+				else if (inside && std::sscanf(line, "Rss: %" SCNu64 " kB", &kb) == 1)
+				{
+					rss += kb * 1024;
+				}
+			}
+
+			std::fclose(f);
+		}
+#endif
+
+		if (resident)
+		{
+			*resident = rss;
+		}
+
+		return huge;
+	}
 }
@@ -32,4 +32,14 @@ namespace utils
 
 	// Set memory protection
 	void memory_protect(void* pointer, std::size_t size, protection prot);
+
+	/**
+	* Advise the OS to back committed memory with 2 MiB pages.
+	* The range is not extended: only 2 MiB blocks fully inside of it can be backed by huge pages.
+	* Returns false if huge pages are not supported.
+	*/
+	bool memory_advise_huge(void* pointer, std::size_t size);
+
+	// Get the amount of memory in the range backed by huge pages (optionally, resident memory total)
+	std::size_t memory_huge_usage(void* pointer, std::size_t size, std::size_t* resident = nullptr);
 }
@@ -0,0 +1,168 @@
+#include "stdafx.h"
+#include "Emu/CPU/CPUThread.h"
+#include "Emu/Cell/PPUThread.h"
+
+#include <chrono>
+#include <thread>
+
+// Minimal CPU thread: counts up to the limit in its "register", then blocks in cpu_wait()
+class test_cpu_thread final : public cpu_thread
+{
+public:
+	using cpu_thread::cpu_thread;
+
+	atomic_t<u64> reg{0};
+	atomic_t<u64> limit{0};
+
+	virtual std::string get_name() const override
+	{
+		return fmt::format("Test CPU[0x%x] Thread", id);
+	}
+
+	virtual void cpu_task() override
+	{
+		while (!test(state) || !check_state())
+		{
+			if (reg < limit)
+			{
+				reg++;
+				continue;
+			}
+
+			cpu_wait();
+		}
+	}
+};
+
+TEST_CLASS(cpu_snapshot)
+{
+	std::shared_ptr<test_cpu_thread> m_thread;
+
+	// Wait until the condition is met
+	template <typename F>
+	static void wait_until(F&& pred)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		while (!pred())
+		{
+			if (std::chrono::steady_clock::now() - start > std::chrono::seconds(5))
+			{
+				TEST_FAILURE("Timeout (%s)", "cpu thread");
+			}
+
+			std::this_thread::yield();
+		}
+	}
+
+	void set_limit(u64 limit)
+	{
+		m_thread->limit = limit;
+		m_thread->notify();
+	}
+
+	TEST_METHOD_INITIALIZE(init)
+	{
+		m_thread = std::make_shared<test_cpu_thread>(1);
+		m_thread->on_init(m_thread);
+		m_thread->run();
+	}
+
+	TEST_METHOD_CLEANUP(cleanup)
+	{
+		m_thread->on_stop();
+		m_thread->join();
+		m_thread.reset();
+	}
+
+	// Pause a running thread, save, continue, restore the saved state and continue from it
+	TEST_METHOD(pause_save_restore)
+	{
+		set_limit(1000000000);
+		wait_until([&] { return m_thread->reg > 1000; });
+
+		Assert::IsTrue(m_thread->snapshot_pause());
+
+		const u64 saved = m_thread->reg;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		Assert::AreEqual(saved, m_thread->reg.load());
+
+		// Continue up to the new limit (the thread then blocks in cpu_wait)
+		m_thread->limit = saved + 1000;
+		m_thread->snapshot_resume();
+		wait_until([&] { return m_thread->reg == saved + 1000; });
+
+		// Restore the saved state in a blocked thread
+		Assert::IsTrue(m_thread->snapshot_pause());
+		m_thread->reg = saved;
+		m_thread->limit = saved + 500;
+		m_thread->snapshot_resume();
+
+		wait_until([&] { return m_thread->reg == saved + 500; });
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		Assert::AreEqual(saved + 500, m_thread->reg.load());
+	}
+
+	// Writers of the registers of a paused thread are blocked until it's resumed
+	TEST_METHOD(writer_blocked)
+	{
+		set_limit(100);
+		wait_until([&] { return m_thread->reg == 100; });
+
+		Assert::IsTrue(m_thread->snapshot_pause());
+
+		atomic_t<u32> written{0};
+
+		std::thread writer([&]
+		{
+			cpu_reg_lock lock(*m_thread);
+			m_thread->reg = 50;
+			written++;
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		Assert::AreEqual(0u, written.load());
+		Assert::AreEqual(u64{100}, m_thread->reg.load());
+
+		m_thread->snapshot_resume();
+		writer.join();
+
+		Assert::AreEqual(1u, written.load());
+
+		// The thread continues from the written value
+		set_limit(200);
+		wait_until([&] { return m_thread->reg == 200; });
+	}
+
+	TEST_METHOD(ppu_context_round_trip)
+	{
+		ppu_thread ppu("Test PPU", 1000, 0x4000);
+
+		for (u32 i = 0; i < 32; i++)
+		{
+			ppu.gpr[i] = 0x0123456789abcdef * (i + 1);
+			ppu.fpr[i] = i * 0.5;
+			ppu.vr[i] = v128::from64(i, ~u64{i});
+			ppu.cr[i] = i % 2;
+		}
+
+		ppu.lr = 0x10000;
+		ppu.ctr = 0x20000;
+		ppu.cia = 0x30000;
+		ppu.xer.ca = true;
+
+		const ppu_thread_context ctx = ppu.save_context();
+
+		ppu_thread other("Test PPU 2", 1000, 0x4000);
+		Assert::IsTrue(other.load_context(ctx));
+
+		Assert::IsTrue(std::memcmp(ppu.gpr, other.gpr, sizeof(ppu.gpr)) == 0);
+		Assert::IsTrue(std::memcmp(ppu.fpr, other.fpr, sizeof(ppu.fpr)) == 0);
+		Assert::IsTrue(std::memcmp(ppu.vr, other.vr, sizeof(ppu.vr)) == 0);
+		Assert::IsTrue(std::memcmp(ppu.cr, other.cr, sizeof(ppu.cr)) == 0);
+		Assert::AreEqual(ppu.lr, other.lr);
+		Assert::AreEqual(ppu.ctr, other.ctr);
+		Assert::AreEqual(ppu.cia, other.cia);
+		Assert::IsTrue(other.xer.ca);
+	}
+};
@@ -0,0 +1,415 @@
+#include "stdafx.h"
+#include "Emu/IdManager.h"
+#include "Emu/Cell/PPUThread.h"
+#include "Emu/Cell/lv2/sys_sync.h"
+#include "Emu/Cell/lv2/sys_net.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#endif
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+extern void network_reactor_init();
+extern void network_reactor_close();
+extern void network_reactor_wait(u32 timeout);
+
+// PPU thread executing the syscalls of the test
+class test_ppu_thread final : public ppu_thread
+{
+public:
+	using ppu_thread::ppu_thread;
+
+	std::function<s32(ppu_thread&)> job;
+	s32 result = 0;
+
+	atomic_t<u32> started{0};
+	atomic_t<u32> finished{0};
+	atomic_t<u32> busy{0};
+
+	virtual void cpu_task() override
+	{
+		while (!test(state) || !check_state())
+		{
+			if (finished < started)
+			{
+				busy = 1;
+				result = job(*this);
+				busy = 0;
+				finished++;
+				continue;
+			}
+
+			cpu_wait();
+		}
+	}
+};
+
+// Loopback tests of the sys_net syscalls waiting for the reactor: every waiter retries its operation under the socket mutex before being queued,
+// so readiness edges consumed by the network thread in between can't be lost. The peer sends through its native socket.
+TEST_CLASS(sys_net_reactor)
+{
+	std::array<std::shared_ptr<test_ppu_thread>, 2> m_ppu;
+
+	// Guest memory for the syscall arguments
+	u32 m_mem = 0;
+
+	// Sockets to close in the cleanup
+	std::vector<s32> m_sockets;
+
+	// Listener address
+	vm::ps3::ptr<sys_net_sockaddr> addr() const
+	{
+		return vm::cast(m_mem);
+	}
+
+	// Receive buffer
+	vm::ps3::ptr<char> buf() const
+	{
+		return vm::cast(m_mem + 0x100);
+	}
+
+	vm::ps3::ptr<sys_net_pollfd> fds() const
+	{
+		return vm::cast(m_mem + 0x200);
+	}
+
+	// Run the reactor until the condition is met
+	template <typename F>
+	static void pump(F&& pred)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		while (!pred())
+		{
+			if (std::chrono::steady_clock::now() - start > std::chrono::seconds(5))
+			{
+				TEST_FAILURE("Timeout (%s)", "reactor");
+			}
+
+			network_reactor_wait(1);
+		}
+	}
+
+	// Start the syscall on the PPU thread
+	static void start(test_ppu_thread& ppu, std::function<s32(ppu_thread&)> func)
+	{
+		ppu.job = std::move(func);
+		ppu.started++;
+		ppu.notify();
+	}
+
+	// Get the result of the syscall
+	static s32 finish(test_ppu_thread& ppu)
+	{
+		pump([&] { return ppu.finished == ppu.started; });
+		return ppu.result;
+	}
+
+	static s32 call(test_ppu_thread& ppu, std::function<s32(ppu_thread&)> func)
+	{
+		start(ppu, std::move(func));
+		return finish(ppu);
+	}
+
+	// Wait until the syscall blocks (the PPU thread was put to sleep by the syscall)
+	static void wait_blocked(test_ppu_thread& ppu)
+	{
+		pump([&] { return ppu.busy && test(ppu.state, cpu_flag::wait); });
+	}
+
+	s32 make_socket()
+	{
+		const s32 s = call(*m_ppu[0], [](ppu_thread& ppu)
+		{
+			return sys_net_bnet_socket(ppu, SYS_NET_AF_INET, SYS_NET_SOCK_STREAM, SYS_NET_IPPROTO_TCP);
+		});
+
+		if (s < 0)
+		{
+			TEST_FAILURE("Failed to create socket (0x%x)", s);
+		}
+
+		m_sockets.emplace_back(s);
+		return s;
+	}
+
+	// Create listening socket bound to the loopback (its address is stored in addr())
+	s32 make_listener()
+	{
+		const s32 s = make_socket();
+
+		const vm::ps3::ptr<sys_net_sockaddr_in> paddr = vm::cast(addr().addr());
+		paddr->sin_len    = sizeof(sys_net_sockaddr_in);
+		paddr->sin_family = SYS_NET_AF_INET;
+		paddr->sin_port   = 0;
+		paddr->sin_addr   = 0x7f000001;
+		paddr->sin_zero   = 0;
+
+		const s32 result = call(*m_ppu[0], [&](ppu_thread& ppu)
+		{
+			s32 result = sys_net_bnet_bind(ppu, s, addr(), sizeof(sys_net_sockaddr_in));
+			if (!result) result = sys_net_bnet_listen(ppu, s, 8);
+			if (!result) result = sys_net_bnet_getsockname(ppu, s, addr(), vm::null);
+			return result;
+		});
+
+		if (result)
+		{
+			TEST_FAILURE("Failed to listen on loopback (0x%x)", result);
+		}
+
+		return s;
+	}
+
+	void start_accept(test_ppu_thread& ppu, s32 listener)
+	{
+		start(ppu, [listener](ppu_thread& ppu)
+		{
+			return sys_net_bnet_accept(ppu, listener, vm::null, vm::null);
+		});
+	}
+
+	void start_connect(test_ppu_thread& ppu, s32 s)
+	{
+		start(ppu, [this, s](ppu_thread& ppu)
+		{
+			return sys_net_bnet_connect(ppu, s, addr(), sizeof(sys_net_sockaddr_in));
+		});
+	}
+
+	void start_recv(test_ppu_thread& ppu, s32 s)
+	{
+		start(ppu, [this, s](ppu_thread& ppu)
+		{
+			return sys_net_bnet_recvfrom(ppu, s, buf(), 1, 0, vm::null, vm::null);
+		});
+	}
+
+	// Get the accepted socket
+	s32 finish_accept(test_ppu_thread& ppu)
+	{
+		const s32 s = finish(ppu);
+
+		if (s < 0)
+		{
+			TEST_FAILURE("Failed to accept (0x%x)", s);
+		}
+
+		m_sockets.emplace_back(s);
+		return s;
+	}
+
+	// Create connected pair of sockets (client, server)
+	std::pair<s32, s32> make_pair()
+	{
+		const s32 listener = make_listener();
+		const s32 client = make_socket();
+
+		start_accept(*m_ppu[0], listener);
+		start_connect(*m_ppu[1], client);
+
+		const s32 server = finish_accept(*m_ppu[0]);
+		Assert::AreEqual(0, finish(*m_ppu[1]));
+
+		return {client, server};
+	}
+
+	static void send_byte(s32 s, char data)
+	{
+		const auto sock = idm::get<lv2_socket>(s);
+
+		if (!sock || ::send(sock->socket, &data, 1, 0) != 1)
+		{
+			TEST_FAILURE("Failed to send %d", data);
+		}
+	}
+
+	TEST_METHOD_INITIALIZE(init)
+	{
+		vm::ps3::init();
+		idm::init();
+		network_reactor_init();
+
+		m_mem = vm::alloc(0x10000, vm::main);
+
+		for (auto& ppu : m_ppu)
+		{
+			ppu = idm::make_ptr<ppu_thread, test_ppu_thread>("Test PPU", 1000, 0x4000);
+			ppu->run();
+		}
+	}
+
+	TEST_METHOD_CLEANUP(cleanup)
+	{
+		// Close the sockets first (destroys the waiters queued by the syscalls interrupted below)
+		for (s32 s : m_sockets)
+		{
+			sys_net_bnet_close(*m_ppu[0], s);
+		}
+
+		for (auto& ppu : m_ppu)
+		{
+			// Interrupt the syscall left blocked by a failed test
+			if (ppu->busy)
+			{
+				lv2_obj::awake(*ppu);
+			}
+
+			idm::remove<ppu_thread>(ppu->id);
+			ppu->join();
+			ppu.reset();
+		}
+
+		m_sockets.clear();
+		lv2_obj::cleanup();
+		network_reactor_close();
+		idm::clear();
+		vm::close();
+	}
+
+	TEST_METHOD(recv_wakeup)
+	{
+		const auto pair = make_pair();
+
+		start_recv(*m_ppu[0], pair.second);
+		wait_blocked(*m_ppu[0]);
+
+		send_byte(pair.first, 'a');
+
+		Assert::AreEqual(1, finish(*m_ppu[0]));
+		Assert::AreEqual('a', buf()[0]);
+	}
+
+	// Data arrives while the syscall retries and queues itself, with the network thread running concurrently
+	TEST_METHOD(recv_concurrent)
+	{
+		const auto pair = make_pair();
+
+		atomic_t<u32> stop{0};
+
+		std::thread reactor([&]
+		{
+			while (!stop)
+			{
+				network_reactor_wait(1);
+			}
+		});
+
+		u32 received = 0;
+
+		try
+		{
+			for (u32 i = 0; i < 1000; i++)
+			{
+				start_recv(*m_ppu[0], pair.second);
+				send_byte(pair.first, static_cast<char>(i));
+
+				if (finish(*m_ppu[0]) != 1 || buf()[0] != static_cast<char>(i))
+				{
+					break;
+				}
+
+				received++;
+			}
+		}
+		catch (...)
+		{
+			stop = 1;
+			reactor.join();
+			throw;
+		}
+
+		stop = 1;
+		reactor.join();
+
+		Assert::AreEqual(1000u, received);
+	}
+
+	// The edge is consumed with no waiter queued: the retry must find the data
+	TEST_METHOD(recv_edge_before_retry)
+	{
+		const auto pair = make_pair();
+
+		send_byte(pair.first, 'c');
+
+		for (u32 i = 0; i < 5; i++)
+		{
+			network_reactor_wait(10);
+		}
+
+		start_recv(*m_ppu[0], pair.second);
+		Assert::AreEqual(1, finish(*m_ppu[0]));
+		Assert::AreEqual('c', buf()[0]);
+
+		// The next edge must still be delivered
+		start_recv(*m_ppu[0], pair.second);
+		wait_blocked(*m_ppu[0]);
+
+		send_byte(pair.first, 'd');
+
+		Assert::AreEqual(1, finish(*m_ppu[0]));
+		Assert::AreEqual('d', buf()[0]);
+	}
+
+	TEST_METHOD(accept_wakeup)
+	{
+		const s32 listener = make_listener();
+		const s32 client = make_socket();
+
+		start_accept(*m_ppu[0], listener);
+		wait_blocked(*m_ppu[0]);
+
+		start_connect(*m_ppu[1], client);
+
+		finish_accept(*m_ppu[0]);
+		Assert::AreEqual(0, finish(*m_ppu[1]));
+	}
+
+	// The connection must not be reported before it's established (the socket was writable since its registration)
+	TEST_METHOD(connect_wakeup)
+	{
+		make_listener();
+		const s32 client = make_socket();
+
+		start_connect(*m_ppu[1], client);
+		Assert::AreEqual(0, finish(*m_ppu[1]));
+
+		Assert::AreEqual(0, call(*m_ppu[1], [&](ppu_thread& ppu)
+		{
+			return sys_net_bnet_getpeername(ppu, client, vm::cast(m_mem + 0x300), vm::null);
+		}));
+	}
+
+	// One edge wakes both a recv waiter and a poll waiter of the same socket
+	TEST_METHOD(poll_wakeup)
+	{
+		const auto pair = make_pair();
+
+		start_recv(*m_ppu[0], pair.second);
+		wait_blocked(*m_ppu[0]);
+
+		fds()->fd = pair.second;
+		fds()->events = SYS_NET_POLLIN;
+
+		start(*m_ppu[1], [this](ppu_thread& ppu)
+		{
+			return sys_net_bnet_poll(ppu, fds(), 1, -1);
+		});
+
+		wait_blocked(*m_ppu[1]);
+
+		send_byte(pair.first, 'e');
+
+		Assert::AreEqual(1, finish(*m_ppu[0]));
+		Assert::AreEqual('e', buf()[0]);
+		Assert::AreEqual(1, finish(*m_ppu[1]));
+		Assert::IsTrue((fds()->revents & SYS_NET_POLLIN) != 0);
+	}
+};
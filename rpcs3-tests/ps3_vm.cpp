@@ -0,0 +1,241 @@
+#include "stdafx.h"
+#include "Emu/Memory/vm.h"
+
+#include <algorithm>
+#include <cstring>
+
+TEST_CLASS(vm_dirty)
+{
+	u32 m_addr = 0;
+
+	static const u32 s_size = 0x10000;
+
+	std::vector<u32> collect(u64& epoch)
+	{
+		std::vector<u32> pages;
+		epoch = vm::dirty_collect(m_addr, s_size, epoch, pages);
+		std::sort(pages.begin(), pages.end());
+		return pages;
+	}
+
+	TEST_METHOD_INITIALIZE(init)
+	{
+		vm::ps3::init();
+		m_addr = vm::alloc(s_size, vm::main);
+		Assert::IsTrue(m_addr != 0);
+		Assert::IsTrue(vm::dirty_track(m_addr, s_size));
+	}
+
+	TEST_METHOD_CLEANUP(cleanup)
+	{
+		vm::dirty_untrack(m_addr);
+		vm::dealloc(m_addr, vm::main);
+		vm::close();
+	}
+
+	TEST_METHOD(overlap)
+	{
+		Assert::IsFalse(vm::dirty_track(m_addr + 0x1000, 0x1000));
+		Assert::IsFalse(vm::dirty_track(m_addr - 0x1000, 0x2000));
+		Assert::IsTrue(vm::dirty_track(m_addr + s_size, 0x1000));
+		vm::dirty_untrack(m_addr + s_size);
+	}
+
+	// The first collection reports all pages and arms them, faults report only written pages
+	TEST_METHOD(arm_fault_collect)
+	{
+		u64 epoch = 0;
+		Assert::AreEqual<std::size_t>(s_size / 4096, collect(epoch).size());
+
+		// Writes fault on armed pages (handled by vm::dirty_fault)
+		vm::ps3::write32(m_addr + 0x2004, 1);
+		vm::ps3::write32(m_addr + 0x2008, 2);
+		vm::ps3::write32(m_addr + 0x5000, 3);
+
+		const auto pages = collect(epoch);
+		Assert::AreEqual<std::size_t>(2, pages.size());
+		Assert::AreEqual(m_addr + 0x2000, pages[0]);
+		Assert::AreEqual(m_addr + 0x5000, pages[1]);
+		Assert::AreEqual<u32>(2, vm::ps3::read32(m_addr + 0x2008));
+
+		// Re-armed: nothing was written since
+		Assert::IsTrue(collect(epoch).empty());
+
+		// Reads don't fault
+		Assert::AreEqual<u32>(3, vm::ps3::read32(m_addr + 0x5000));
+		Assert::IsTrue(collect(epoch).empty());
+	}
+
+	// An older epoch still gets all pages written since it
+	TEST_METHOD(collect_since)
+	{
+		u64 epoch = 0;
+		collect(epoch);
+		const u64 first = epoch;
+
+		vm::ps3::write32(m_addr, 1);
+		collect(epoch);
+
+		vm::ps3::write32(m_addr + 0x1000, 2);
+
+		u64 since = first;
+		Assert::AreEqual<std::size_t>(2, collect(since).size());
+	}
+
+	// Host OS writes unarm the pages before writing
+	TEST_METHOD(host_write)
+	{
+		u64 epoch = 0;
+		collect(epoch);
+
+		{
+			vm::dirty_host_write dirty(m_addr + 0x3ff0, 0x20);
+			std::memset(vm::base(m_addr + 0x3ff0), 0xff, 0x20);
+
+			// Pages aren't re-armed while the host writes
+			Assert::AreEqual<std::size_t>(2, collect(epoch).size());
+		}
+
+		Assert::AreEqual<std::size_t>(2, collect(epoch).size());
+		Assert::IsTrue(collect(epoch).empty());
+	}
+
+	// Pages mapped again are reported as dirty
+	TEST_METHOD(remap)
+	{
+		u64 epoch = 0;
+		collect(epoch);
+
+		vm::dealloc(m_addr, vm::main);
+		Assert::AreEqual(m_addr, vm::falloc(m_addr, s_size, vm::main));
+
+		Assert::AreEqual<std::size_t>(s_size / 4096, collect(epoch).size());
+	}
+};
+
+TEST_CLASS(vm_snapshot)
+{
+	static const u32 s_size = 0x10000;
+
+	// Fill the range with a pattern
+	static void fill(u32 addr, u32 size, u32 seed)
+	{
+		for (u32 i = 0; i < size; i += 4)
+		{
+			vm::ps3::write32(addr + i, seed ^ i);
+		}
+	}
+
+	static bool check(u32 addr, u32 size, u32 seed)
+	{
+		for (u32 i = 0; i < size; i += 4)
+		{
+			if (vm::ps3::read32(addr + i) != (seed ^ i))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static std::vector<u8> read_all(const fs::file& file)
+	{
+		std::vector<u8> result(file.size());
+		file.seek(0);
+		file.read(result.data(), result.size());
+		return result;
+	}
+
+	TEST_METHOD_INITIALIZE(init)
+	{
+		vm::ps3::init();
+	}
+
+	TEST_METHOD_CLEANUP(cleanup)
+	{
+		vm::close();
+	}
+
+	TEST_METHOD(save_restore)
+	{
+		const u32 a = vm::alloc(s_size, vm::main);
+		const u32 b = vm::alloc(s_size * 4, vm::user_space, 0x100000, 0x1234);
+		Assert::IsTrue(a && b);
+
+		fill(a, s_size, 0x11111111);
+		fill(b, s_size * 4, 0x22222222);
+		Assert::IsTrue(vm::page_protect(a + 0x1000, 0x1000, 0, 0, vm::page_writable));
+
+		const fs::file file = fs::make_stream<std::vector<u8>>();
+		Assert::IsTrue(vm::snapshot_save(file));
+
+		// Change everything
+		Assert::IsTrue(vm::page_protect(a + 0x1000, 0x1000, 0, vm::page_writable));
+		fill(a, s_size, 0x33333333);
+		vm::dealloc(b, vm::user_space);
+		const u32 c = vm::alloc(s_size, vm::video);
+		Assert::IsTrue(c != 0);
+
+		file.seek(0);
+		Assert::IsTrue(vm::snapshot_load(file));
+
+		Assert::IsTrue(check(a, s_size, 0x11111111));
+		Assert::IsTrue(check(b, s_size * 4, 0x22222222));
+		Assert::IsFalse(vm::check_addr(a + 0x1000, 1, vm::page_writable));
+		Assert::IsTrue(vm::check_addr(a + 0x2000, 1, vm::page_writable));
+		Assert::IsFalse(vm::check_addr(c));
+
+		u32 sup = 0;
+		Assert::AreEqual(s_size * 4, vm::dealloc(b, vm::user_space, &sup));
+		Assert::AreEqual(0x1234u, sup);
+	}
+
+	// Ranges tracked by another user are copied with the guest stopped and stay tracked
+	TEST_METHOD(foreign_tracking)
+	{
+		const u32 a = vm::alloc(s_size, vm::main);
+		fill(a, s_size, 0x44444444);
+
+		Assert::IsTrue(vm::dirty_track(a, s_size));
+
+		std::vector<u32> pages;
+		const u64 epoch = vm::dirty_collect(a, s_size, 0, pages);
+
+		const fs::file file = fs::make_stream<std::vector<u8>>();
+		Assert::IsTrue(vm::snapshot_save(file));
+
+		// Still armed
+		vm::ps3::write32(a, 0);
+		pages.clear();
+		vm::dirty_collect(a, s_size, epoch, pages);
+		Assert::AreEqual<std::size_t>(1, pages.size());
+		vm::dirty_untrack(a);
+
+		file.seek(0);
+		Assert::IsTrue(vm::snapshot_load(file));
+		Assert::IsTrue(check(a, s_size, 0x44444444));
+	}
+
+	// Damaged streams are rejected before the current state is destroyed
+	TEST_METHOD(damaged_stream)
+	{
+		const u32 a = vm::alloc(s_size, vm::main);
+		fill(a, s_size, 0x55555555);
+
+		const fs::file file = fs::make_stream<std::vector<u8>>();
+		Assert::IsTrue(vm::snapshot_save(file));
+
+		auto data = read_all(file);
+		fill(a, s_size, 0x66666666);
+
+		// Truncated
+		Assert::IsFalse(vm::snapshot_load(fs::make_stream(std::vector<u8>(data.begin(), data.end() - 16))));
+
+		// Corrupted
+		data[data.size() / 2] ^= 0xff;
+		Assert::IsFalse(vm::snapshot_load(fs::make_stream(std::move(data))));
+
+		Assert::IsTrue(check(a, s_size, 0x66666666));
+	}
+};
@@ -1,7 +1,11 @@
 #pragma once
 
 // Headers for CppUnitTest
+#ifdef _MSC_VER
 #include "CppUnitTest.h"
+#else
+#include "unit_test.h"
+#endif
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -0,0 +1,114 @@
+#include "stdafx.h"
+
+#include <cstdio>
+#include <cstring>
+
+std::vector<unit_test::test_class_info>& unit_test::get_classes()
+{
+	static std::vector<test_class_info> classes;
+	return classes;
+}
+
+namespace Microsoft { namespace VisualStudio { namespace CppUnitTestFramework
+{
+	static std::string to_utf8(const wchar_t* message)
+	{
+		return message ? std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(message) : std::string{};
+	}
+
+	void Logger::WriteMessage(const char* message)
+	{
+		std::printf("%s\n", message);
+	}
+
+	void Logger::WriteMessage(const wchar_t* message)
+	{
+		std::printf("%s\n", to_utf8(message).c_str());
+	}
+
+	void Assert::Fail(const wchar_t* message, const line_info* info)
+	{
+		if (info)
+		{
+			throw unit_test::failure{fmt::format("%s (%s:%d)", to_utf8(message), info->func, info->line)};
+		}
+
+		throw unit_test::failure{to_utf8(message)};
+	}
+}}}
+
+// Run the test, return the error message or an empty string
+static std::string run_test(const std::function<void()>& func)
+{
+	try
+	{
+		if (func)
+		{
+			func();
+		}
+
+		return {};
+	}
+	catch (const unit_test::failure& e)
+	{
+		return e.message.empty() ? "Assert::Fail" : e.message;
+	}
+	catch (const std::exception& e)
+	{
+		return fmt::format("Exception: %s", e.what());
+	}
+}
+
+// Usage: rpcs3-tests [filter] (runs the methods whose "class::method" name contains the filter)
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : "";
+
+	u32 passed = 0;
+	u32 failed = 0;
+
+	for (const auto& info : unit_test::get_classes())
+	{
+		// Every method is run on a new instance (as CppUnitTest does)
+		const std::size_t count = info.make()->test_methods.size();
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			const auto test = info.make();
+			const std::string name = fmt::format("%s::%s", info.name, test->test_methods[i].first);
+
+			if (!std::strstr(name.c_str(), filter))
+			{
+				continue;
+			}
+
+			std::string error = run_test(test->test_init);
+
+			if (error.empty())
+			{
+				error = run_test(test->test_methods[i].second);
+
+				const std::string cleanup_error = run_test(test->test_cleanup);
+
+				if (error.empty())
+				{
+					error = cleanup_error;
+				}
+			}
+
+			if (error.empty())
+			{
+				std::printf("[  OK  ] %s\n", name.c_str());
+				passed++;
+			}
+			else
+			{
+				std::printf("[FAILED] %s: %s\n", name.c_str(), error.c_str());
+				failed++;
+			}
+		}
+	}
+
+	std::printf("%u passed, %u failed\n", passed, failed);
+	return failed ? 1 : 0;
+}
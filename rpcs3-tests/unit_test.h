@@ -0,0 +1,126 @@
+#pragma once
+
+// Minimal replacement of the MSVC CppUnitTest framework (used by the CMake build, see unit_test.cpp)
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace unit_test
+{
+	// Failed assertion
+	struct failure
+	{
+		std::string message;
+	};
+
+	// Methods of the test class instance (registered by the member initializers)
+	struct test_class
+	{
+		std::function<void()> test_init;
+		std::function<void()> test_cleanup;
+		std::vector<std::pair<const char*, std::function<void()>>> test_methods;
+
+		virtual ~test_class() = default;
+	};
+
+	struct test_class_info
+	{
+		const char* name;
+		std::unique_ptr<test_class>(*make)();
+	};
+
+	std::vector<test_class_info>& get_classes();
+
+	// Register the test class (must be instantiated after the class is defined)
+	template <typename T>
+	bool register_class(const char* name)
+	{
+		get_classes().push_back({name, []() -> std::unique_ptr<test_class> { return std::make_unique<T>(); }});
+		return true;
+	}
+
+	enum class entry_type
+	{
+		init,
+		cleanup,
+		method,
+	};
+
+	struct test_entry
+	{
+		test_entry(test_class& _this, entry_type type, const char* name, std::function<void()> func)
+		{
+			switch (type)
+			{
+			case entry_type::init: _this.test_init = std::move(func); break;
+			case entry_type::cleanup: _this.test_cleanup = std::move(func); break;
+			case entry_type::method: _this.test_methods.emplace_back(name, std::move(func)); break;
+			}
+		}
+	};
+}
+
+namespace Microsoft { namespace VisualStudio { namespace CppUnitTestFramework
+{
+	struct line_info
+	{
+		const char* file;
+		const char* func;
+		int line;
+
+		const line_info* get() const
+		{
+			return this;
+		}
+	};
+
+	class Logger
+	{
+	public:
+		static void WriteMessage(const char* message);
+		static void WriteMessage(const wchar_t* message);
+	};
+
+	class Assert
+	{
+	public:
+		static void Fail(const wchar_t* message = nullptr, const line_info* info = nullptr);
+
+		static void IsTrue(bool condition, const wchar_t* message = nullptr, const line_info* info = nullptr)
+		{
+			if (!condition) Fail(message ? message : L"Assert::IsTrue failed", info);
+		}
+
+		static void IsFalse(bool condition, const wchar_t* message = nullptr, const line_info* info = nullptr)
+		{
+			if (condition) Fail(message ? message : L"Assert::IsFalse failed", info);
+		}
+
+		template <typename T>
+		static void AreEqual(const T& expected, const T& actual, const wchar_t* message = nullptr, const line_info* info = nullptr)
+		{
+			if (!(expected == actual)) Fail(message ? message : L"Assert::AreEqual failed", info);
+		}
+	};
+}}}
+
+#define LINE_INFO() Microsoft::VisualStudio::CppUnitTestFramework::line_info{__FILE__, __FUNCTION__, __LINE__}.get()
+
+#define TEST_CLASS(name)\
+	struct name;\
+	static const bool name##_registered = unit_test::register_class<name>(#name);\
+	struct name : unit_test::test_class
+
+#define TEST_METHOD_INITIALIZE(name)\
+	unit_test::test_entry name##_entry{*this, unit_test::entry_type::init, #name, [this] { this->name(); }};\
+	public: void name()
+
+#define TEST_METHOD_CLEANUP(name)\
+	unit_test::test_entry name##_entry{*this, unit_test::entry_type::cleanup, #name, [this] { this->name(); }};\
+	public: void name()
+
+#define TEST_METHOD(name)\
+	unit_test::test_entry name##_entry{*this, unit_test::entry_type::method, #name, [this] { this->name(); }};\
+	public: void name()
@@ -5,6 +5,7 @@
 #include "Emu/IdManager.h"
 #include "Utilities/GDBDebugServer.h"
 #include <typeinfo>
+#include <thread>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -30,6 +31,9 @@ void fmt_class_string<cpu_flag>::format(std::string& out, u64 arg)
 		case cpu_flag::dbg_global_stop: return "G-EXIT";
 		case cpu_flag::dbg_pause: return "PAUSE";
 		case cpu_flag::dbg_step: return "STEP";
+		case cpu_flag::snapshot: return "SNAP";
+		case cpu_flag::parked: return "park";
+		case cpu_flag::wait: return "wait";
 		case cpu_flag::__bitset_enum_max: break;
 		}
 
@@ -131,7 +135,17 @@ bool cpu_thread::check_state()
 			cpu_sleep_called = false;
 		}
 
-		if (!test(state, cpu_state_pause))
+		// Leave the pause point (drop the acknowledgement atomically, unless a new snapshot request arrived)
+		if (state.atomic_op([](bs_t<cpu_flag>& val)
+		{
+			if (test(val, cpu_state_pause))
+			{
+				return false;
+			}
+
+			val -= cpu_flag::parked;
+			return true;
+		}))
 		{
 			if (cpu_flag_memory) vm::passive_lock(*this);
 			break;
@@ -142,6 +156,12 @@ bool cpu_thread::check_state()
 			cpu_sleep_called = true;
 			continue;
 		}
+		else if (test(state, cpu_flag::snapshot) && !test(state, cpu_flag::parked))
+		{
+			// Acknowledge snapshot request: registers are stable from now on
+			state += cpu_flag::parked;
+			continue;
+		}
 
 		thread_ctrl::wait();
 	}
@@ -179,7 +199,84 @@ void cpu_thread::run()
 	notify();
 }
 
+bool cpu_thread::snapshot_pause()
+{
+	state += cpu_flag::snapshot;
+	notify();
+
+	// Wait until the thread parks itself in check_state() or blocks in cpu_wait() (stopped threads don't execute)
+	for (u32 i = 0; i < 1000; i++)
+	{
+		// Also wait for the writers which modify registers of the blocked thread (results of a syscall), and block new ones
+		if (test(state, cpu_flag::parked + cpu_flag::wait + cpu_flag::stop + cpu_flag::exit) && reg_mutex.try_lock())
+		{
+			m_reg_locked = true;
+			return true;
+		}
+
+		std::this_thread::sleep_for(1ms);
+	}
+
+	LOG_ERROR(GENERAL, "Snapshot pause timed out (state: %s)", state.load());
+	snapshot_resume();
+	return false;
+}
+
+void cpu_thread::snapshot_resume()
+{
+	if (m_reg_locked)
+	{
+		m_reg_locked = false;
+		reg_mutex.unlock();
+	}
+
+	state -= cpu_flag::snapshot;
+	notify();
+}
+
+bool cpu_thread::cpu_wait(u64 usec)
+{
+	state += cpu_flag::wait;
+
+	const bool result = thread_ctrl::wait_for(usec);
+
+	// Don't return to the caller (which may modify registers) while the snapshot is being taken
+	while (!state.atomic_op([](bs_t<cpu_flag>& val)
+	{
+		if (test(val, cpu_flag::snapshot) && !test(val, cpu_flag::exit + cpu_flag::dbg_global_stop))
+		{
+			return false;
+		}
+
+		val -= cpu_flag::wait;
+		return true;
+	}))
+	{
+		thread_ctrl::wait();
+	}
+
+	return result;
+}
+
 std::string cpu_thread::dump() const
 {
 	return fmt::format("Type: %s\n" "State: %s\n", typeid(*this).name(), state.load());
 }
+
+cpu_reg_lock::cpu_reg_lock(cpu_thread& cpu)
+	: m_cpu(cpu)
+{
+	const auto _cpu = get_current_cpu_thread();
+
+	while (!cpu.reg_mutex.try_lock_shared())
+	{
+		if (!_cpu || _cpu == &cpu)
+		{
+			cpu.reg_mutex.lock_shared();
+			break;
+		}
+
+		// Blocked writer must not delay its own snapshot (it doesn't hold the lock while waiting)
+		_cpu->cpu_wait(100);
+	}
+}
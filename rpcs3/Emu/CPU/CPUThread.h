@@ -2,6 +2,7 @@
 
 #include "../Utilities/Thread.h"
 #include "../Utilities/bit_set.h"
+#include "../Utilities/mutex.h"
 
 // Thread state flags
 enum class cpu_flag : u32
@@ -18,16 +19,23 @@ enum class cpu_flag : u32
 	dbg_pause, // Thread paused
 	dbg_step, // Thread forced to pause after one step (one instruction, etc)
 
+	snapshot, // Thread paused for context snapshot
+	parked, // Thread reached pause point (set by the thread itself)
+	wait, // Thread is blocked in cpu_wait() (registers are stable)
+
 	__bitset_enum_max
 };
 
 // Flag set for pause state
-constexpr bs_t<cpu_flag> cpu_state_pause = cpu_flag::suspend + cpu_flag::dbg_global_pause + cpu_flag::dbg_pause;
+constexpr bs_t<cpu_flag> cpu_state_pause = cpu_flag::suspend + cpu_flag::dbg_global_pause + cpu_flag::dbg_pause + cpu_flag::snapshot;
 
 class cpu_thread : public named_thread
 {
 	void on_task() override final;
 
+	// Set if reg_mutex is locked exclusively by snapshot_pause()
+	bool m_reg_locked = false;
+
 public:
 	virtual void on_stop() override;
 	virtual ~cpu_thread() override;
@@ -39,6 +47,9 @@ public:
 	// Public thread state
 	atomic_t<bs_t<cpu_flag>> state{+cpu_flag::stop};
 
+	// Registers modified by other threads must be written under this lock (see cpu_reg_lock)
+	shared_mutex reg_mutex;
+
 	// Process thread state, return true if the checker must return
 	bool check_state();
 
@@ -48,6 +59,16 @@ public:
 	// Run thread
 	void run();
 
+	// Pause thread at consistent point for context snapshot, also block writes from other threads (returns false on timeout)
+	bool snapshot_pause();
+
+	// Resume thread paused by snapshot_pause()
+	void snapshot_resume();
+
+	// Wait for notification inside of a blocking syscall or channel operation, also a pause point for snapshot_pause().
+	// Returns true if notified (see thread_ctrl::wait_for). Must not be called with modified but not yet visible registers.
+	bool cpu_wait(u64 usec = -1);
+
 	// Check thread type
 	u32 id_type()
 	{
@@ -73,3 +94,19 @@ inline cpu_thread* get_current_cpu_thread() noexcept
 
 	return g_tls_current_cpu_thread;
 }
+
+// Lock registers of another thread for modification (waits while the thread is paused by snapshot_pause())
+class cpu_reg_lock final
+{
+	cpu_thread& m_cpu;
+
+public:
+	cpu_reg_lock(const cpu_reg_lock&) = delete;
+
+	explicit cpu_reg_lock(cpu_thread& cpu);
+
+	~cpu_reg_lock()
+	{
+		m_cpu.reg_mutex.unlock_shared();
+	}
+};
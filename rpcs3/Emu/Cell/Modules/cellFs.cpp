@@ -10,6 +10,9 @@
 #include "Utilities/StrUtil.h"
 
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
 
 namespace vm { using namespace ps3; }
 
@@ -871,46 +874,147 @@ struct fs_aio_thread : ppu_thread
 
 	virtual void cpu_task() override
 	{
+		// Completed requests, posted in submission order by the I/O workers
 		while (cmd64 cmd = cmd_wait())
 		{
-			const u32 type = cmd.arg1<u32>();
+			const s32 error = cmd.arg1<s32>();
 			const s32 xid = cmd.arg2<s32>();
 			const cmd64 cmd2 = cmd_get(1);
 			const auto aio = cmd2.arg1<vm::ptr<CellFsAio>>();
 			const auto func = cmd2.arg2<fs_aio_cb_t>();
-			cmd_pop(1);
+			const u64 result = cmd_get(2).as<u64>();
+			cmd_pop(2);
 
-			s32 error = CELL_OK;
-			u64 result = 0;
+			func(*this, aio, error, xid, result);
+			lv2_obj::sleep(*this);
+		}
+	}
+};
+
+struct fs_aio_request
+{
+	u32 type; // 1 = read, 2 = write
+	s32 xid;
+	vm::ptr<CellFsAio> aio;
+	fs_aio_cb_t func;
+
+	bool done = false;
+	s32 error = CELL_OK;
+	u64 result = 0;
+};
+
+struct fs_aio_manager
+{
+	// Number of host threads doing the I/O
+	static const u32 worker_count = 4;
+
+	std::shared_ptr<fs_aio_thread> thread;
+
+	// Plain host threads: they block until a request or destruction (emulation stop doesn't wait for them)
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool stop = false;
+	std::deque<std::shared_ptr<fs_aio_request>> pending; // Not started yet
+	std::deque<std::shared_ptr<fs_aio_request>> order; // Not completed yet, in submission order
 
-			const auto file = idm::get<lv2_fs_object, lv2_file>(aio->fd);
+	~fs_aio_manager()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+
+		cv.notify_all();
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	void submit(u32 type, s32 xid, vm::ptr<CellFsAio> aio, fs_aio_cb_t func)
+	{
+		auto req = std::make_shared<fs_aio_request>();
+		req->type = type;
+		req->xid = xid;
+		req->aio = aio;
+		req->func = func;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			order.emplace_back(req);
+			pending.emplace_back(std::move(req));
+		}
+
+		cv.notify_one();
+	}
 
-			if (!file || (type == 1 && file->flags & CELL_FS_O_WRONLY) || (type == 2 && !(file->flags & CELL_FS_O_ACCMODE)))
+	void work()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (true)
+		{
+			cv.wait(lock, [&] { return stop || !pending.empty(); });
+
+			if (stop)
 			{
-				error = CELL_EBADF;
+				return;
 			}
-			else
-			{
-				std::lock_guard<std::mutex> lock(file->mp->mutex);
 
-				const auto old_pos = file->file.pos(); file->file.seek(aio->offset);
+			const auto req = std::move(pending.front());
+			pending.pop_front();
 
-				result = type == 2
-					? file->op_write(aio->buf, aio->size)
-					: file->op_read(aio->buf, aio->size);
+			lock.unlock();
+			execute(*req);
+			lock.lock();
 
-				file->file.seek(old_pos);
-			}
+			req->done = true;
 
-			func(*this, aio, error, xid, result);
-			lv2_obj::sleep(*this);
+			// Post completions to the callback thread in order
+			while (!order.empty() && order.front()->done)
+			{
+				const auto& front = *order.front();
+
+				thread->cmd_list
+				({
+					{ front.error, front.xid },
+					{ front.aio, front.func },
+					front.result,
+				});
+
+				order.pop_front();
+				thread->notify();
+			}
 		}
 	}
-};
 
-struct fs_aio_manager
-{
-	std::shared_ptr<fs_aio_thread> thread;
+	static void execute(fs_aio_request& req)
+	{
+		const auto aio = req.aio;
+		const auto file = idm::get<lv2_fs_object, lv2_file>(aio->fd);
+
+		if (!file || (req.type == 1 && file->flags & CELL_FS_O_WRONLY) || (req.type == 2 && !(file->flags & CELL_FS_O_ACCMODE)))
+		{
+			req.error = CELL_EBADF;
+			return;
+		}
+
+		// Native files support real positional access, others may temporarily move the file position
+		std::unique_lock<std::mutex> lock(file->mp->mutex, std::defer_lock);
+
+		if (!file->is_positional())
+		{
+			lock.lock();
+		}
+
+		req.result = req.type == 2
+			? file->op_write_at(aio->offset, aio->buf, aio->size)
+			: file->op_read_at(aio->offset, aio->buf, aio->size);
+	}
 };
 
 s32 cellFsAioInit(vm::cptr<char> mount_point)
@@ -924,6 +1028,15 @@ s32 cellFsAioInit(vm::cptr<char> mount_point)
 	{
 		m->thread = idm::make_ptr<ppu_thread, fs_aio_thread>("FS AIO Thread", 500);
 		m->thread->run();
+
+		for (u32 i = 0; i < fs_aio_manager::worker_count; i++)
+		{
+			// Joined in the destructor of the manager
+			m->workers.emplace_back([ptr = m.get()]
+			{
+				ptr->work();
+			});
+		}
 	}
 
 	return CELL_OK;
@@ -955,13 +1068,7 @@ s32 cellFsAioRead(vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
 
 	const s32 xid = (*id = ++g_fs_aio_id);
 
-	m->thread->cmd_list
-	({
-		{ 1, xid },
-		{ aio, func },
-	});
-
-	m->thread->notify();
+	m->submit(1, xid, aio, func);
 
 	return CELL_OK;
 }
@@ -981,13 +1088,7 @@ s32 cellFsAioWrite(vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
 
 	const s32 xid = (*id = ++g_fs_aio_id);
 
-	m->thread->cmd_list
-	({
-		{ 2, xid },
-		{ aio, func },
-	});
-
-	m->thread->notify();
+	m->submit(2, xid, aio, func);
 
 	return CELL_OK;
 }
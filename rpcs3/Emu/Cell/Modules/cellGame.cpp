@@ -396,6 +396,7 @@ error_code cellGameContentPermit(vm::ptr<char[CELL_GAME_PATH_MAX]> contentInfoPa
 
 		// Create PARAM.SFO
 		psf::save_object(fs::file(vdir + "/PARAM.SFO", fs::rewrite), prm->sfo);
+		vfs::invalidate(dir);
 
 		// Disable deletion
 		prm->temp.clear();
@@ -478,6 +479,8 @@ error_code cellGameDataCheckCreate2(ppu_thread& ppu, u32 version, vm::cptr<char>
 			return {CELL_GAME_ERROR_ACCESS_ERROR, usrdir};
 		}
 
+		vfs::invalidate(dir);
+
 		if (cbSet->setParam)
 		{
 			psf::assign(sfo, "CATEGORY", psf::string(3, "GD"));
@@ -504,6 +507,7 @@ error_code cellGameDataCheckCreate2(ppu_thread& ppu, u32 version, vm::cptr<char>
 			}
 
 			psf::save_object(fs::file(vdir + "/PARAM.SFO", fs::rewrite), sfo);
+			vfs::invalidate(dir);
 		}
 
 		return CELL_OK;
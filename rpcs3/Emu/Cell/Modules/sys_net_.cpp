@@ -31,6 +31,9 @@ static NEVER_INLINE vm::ptr<sys_net_tls_data> get_tls()
 		thread_ctrl::atexit([addr = g_tls_net_data.addr()]
 		{
 			vm::dealloc_verbose_nothrow(addr, vm::main);
+
+			// Host thread may be reused by another guest thread
+			g_tls_net_data = vm::null;
 		});
 	}
 
@@ -2542,32 +2542,22 @@ bool ppu_interpreter_precise::VSUM2SWS(ppu_thread& ppu, ppu_opcode_t op)
 	return true;
 }
 
-bool ppu_interpreter_fast::VSUM4SBS(ppu_thread& ppu, ppu_opcode_t op)
+// Signed 32-bit saturating addition
+inline __m128i sse_adds_epi32(__m128i a, __m128i b)
 {
-	auto& d = ppu.vr[op.vd];
-	const auto& a = ppu.vr[op.va];
-	const auto& b = ppu.vr[op.vb];
-
-	for (uint w = 0; w < 4; w++)
-	{
-		s64 sum = b._s32[w];
-
-		for (uint b = 0; b < 4; b++)
-		{
-			sum += a._s8[w * 4 + b];
-		}
+	const auto s = _mm_add_epi32(a, b);
+	const auto m = _mm_and_si128(_mm_xor_si128(a, s), _mm_xor_si128(b, s)); // overflow bit
+	const auto x = _mm_srai_epi32(m, 31); // saturation mask
+	const auto y = _mm_srai_epi32(_mm_and_si128(s, m), 31); // positive saturation mask
+	return _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(x, 1), y), _mm_or_si128(s, x));
+}
 
-		if (sum > INT32_MAX)
-		{
-			d._s32[w] = (s32)INT32_MAX;
-		}
-		else if (sum < INT32_MIN)
-		{
-			d._s32[w] = (s32)INT32_MIN;
-		}
-		else
-			d._s32[w] = (s32)sum;
-	}
+bool ppu_interpreter_fast::VSUM4SBS(ppu_thread& ppu, ppu_opcode_t op)
+{
+	const auto a = ppu.vr[op.va].vi;
+	const auto h = _mm_add_epi16(_mm_srai_epi16(_mm_slli_epi16(a, 8), 8), _mm_srai_epi16(a, 8)); // sums of byte pairs
+	const auto s = _mm_madd_epi16(h, _mm_set1_epi16(1)); // sums of 4 bytes
+	ppu.vr[op.vd].vi = sse_adds_epi32(ppu.vr[op.vb].vi, s);
 	return true;
 }
 
@@ -2604,30 +2594,8 @@ bool ppu_interpreter_precise::VSUM4SBS(ppu_thread& ppu, ppu_opcode_t op)
 
 bool ppu_interpreter_fast::VSUM4SHS(ppu_thread& ppu, ppu_opcode_t op)
 {
-	auto& d = ppu.vr[op.vd];
-	const auto& a = ppu.vr[op.va];
-	const auto& b = ppu.vr[op.vb];
-
-	for (uint w = 0; w < 4; w++)
-	{
-		s64 sum = b._s32[w];
-
-		for (uint h = 0; h < 2; h++)
-		{
-			sum += a._s16[w * 2 + h];
-		}
-
-		if (sum > INT32_MAX)
-		{
-			d._s32[w] = (s32)INT32_MAX;
-		}
-		else if (sum < INT32_MIN)
-		{
-			d._s32[w] = (s32)INT32_MIN;
-		}
-		else
-			d._s32[w] = (s32)sum;
-	}
+	const auto s = _mm_madd_epi16(ppu.vr[op.va].vi, _mm_set1_epi16(1)); // sums of halfword pairs
+	ppu.vr[op.vd].vi = sse_adds_epi32(ppu.vr[op.vb].vi, s);
 	return true;
 }
 
@@ -2664,26 +2632,12 @@ bool ppu_interpreter_precise::VSUM4SHS(ppu_thread& ppu, ppu_opcode_t op)
 
 bool ppu_interpreter_fast::VSUM4UBS(ppu_thread& ppu, ppu_opcode_t op)
 {
-	auto& d = ppu.vr[op.vd];
-	const auto& a = ppu.vr[op.va];
-	const auto& b = ppu.vr[op.vb];
-
-	for (uint w = 0; w < 4; w++)
-	{
-		u64 sum = b._u32[w];
-
-		for (uint b = 0; b < 4; b++)
-		{
-			sum += a._u8[w * 4 + b];
-		}
-
-		if (sum > UINT32_MAX)
-		{
-			d._u32[w] = (u32)UINT32_MAX;
-		}
-		else
-			d._u32[w] = (u32)sum;
-	}
+	const auto a = ppu.vr[op.va].vi;
+	const auto b = ppu.vr[op.vb].vi;
+	const auto h = _mm_add_epi16(_mm_and_si128(a, _mm_set1_epi16(0xff)), _mm_srli_epi16(a, 8)); // sums of byte pairs
+	const auto r = _mm_add_epi32(b, _mm_madd_epi16(h, _mm_set1_epi16(1)));
+	const auto c = _mm_cmpgt_epi32(_mm_xor_si128(b, _mm_set1_epi32(0x80000000)), _mm_xor_si128(r, _mm_set1_epi32(0x80000000))); // carry
+	ppu.vr[op.vd].vi = _mm_or_si128(r, c);
 	return true;
 }
 
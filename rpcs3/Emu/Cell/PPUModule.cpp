@@ -16,6 +16,7 @@
 #include <map>
 #include <set>
 #include <algorithm>
+#include <ctime>
 
 namespace vm { using namespace ps3; }
 
@@ -706,6 +707,118 @@ static auto ppu_load_imports(std::vector<ppu_reloc>& relocs, const std::shared_p
 	return result;
 }
 
+// Remove the least recently used decrypted PRX images if the cache directory holds too many
+static void ppu_prx_cache_evict(const std::string& cache_dir)
+{
+	// Well above the number of modules loaded by one title
+	const std::size_t max_count = 256;
+
+	// Pairs of last use time and file name (also includes temporary files left by an interrupted write)
+	std::vector<std::pair<s64, std::string>> images;
+
+	for (auto&& entry : fs::dir{cache_dir})
+	{
+		if (!entry.is_directory && entry.name.compare(0, 4, "prx-") == 0)
+		{
+			images.emplace_back(entry.mtime, std::move(entry.name));
+		}
+	}
+
+	if (images.size() <= max_count)
+	{
+		return;
+	}
+
+	std::sort(images.begin(), images.end());
+
+	for (std::size_t i = 0; i < images.size() - max_count; i++)
+	{
+		LOG_NOTICE(LOADER, "Removing decrypted PRX cache: %s", images[i].second);
+		fs::remove_file(cache_dir + images[i].second);
+	}
+}
+
+// Decrypt PRX file, reusing the decrypted image from the cache if the same SELF was decrypted before
+extern fs::file ppu_decrypt_prx(fs::file src, const std::string& path, u8* klic_key)
+{
+	if (!src || src.size() < 4 || (src.seek(0), src.read<u32>() != "SCE\0"_u32))
+	{
+		// Not encrypted (or invalid)
+		return decrypt_self(std::move(src), klic_key);
+	}
+
+	// Hash the whole SELF and the key
+	sha1_context ctx;
+	u8 hash[20];
+	sha1_starts(&ctx);
+
+	std::vector<u8> buf(0x10000);
+
+	src.seek(0);
+
+	while (const u64 read = src.read(buf.data(), buf.size()))
+	{
+		sha1_update(&ctx, buf.data(), read);
+	}
+
+	if (klic_key)
+	{
+		sha1_update(&ctx, klic_key, 16);
+	}
+
+	sha1_finish(&ctx, hash);
+
+	// Same placement as PPU cache: firmware modules are shared, others are per title
+	const std::string flash_dir = vfs::get("/dev_flash/");
+	const std::string cache_dir = fs::get_data_dir(path.compare(0, flash_dir.size(), flash_dir) == 0 ? "" : Emu.GetTitleID(), path);
+	const std::string cache_file = fmt::format("%sprx-%016llx%08x.elf", cache_dir, reinterpret_cast<be_t<u64>&>(hash[0]), reinterpret_cast<be_t<u32>&>(hash[8]));
+
+	if (fs::file cached{cache_file})
+	{
+		if (ppu_prx_object{cached} == elf_error::ok)
+		{
+			LOG_NOTICE(LOADER, "Using decrypted PRX cache: %s", cache_file);
+
+			// Update the last use time for the eviction
+			const s64 now = std::time(nullptr);
+			fs::utime(cache_file, now, now);
+
+			cached.seek(0);
+			return cached;
+		}
+
+		// Damaged image: decrypt again
+		LOG_ERROR(LOADER, "Invalid decrypted PRX cache: %s", cache_file);
+		cached.close();
+		fs::remove_file(cache_file);
+	}
+
+	fs::file elf = decrypt_self(std::move(src), klic_key);
+
+	if (elf && ppu_prx_object{elf} == elf_error::ok)
+	{
+		// Write the image atomically to not leave partial files behind
+		const std::string tmp_file = cache_file + ".tmp";
+
+		if (fs::file out{tmp_file, fs::rewrite})
+		{
+			out.write(elf.to_vector<u8>());
+			out.close();
+
+			if (!fs::rename(tmp_file, cache_file, true))
+			{
+				fs::remove_file(tmp_file);
+			}
+
+			ppu_prx_cache_evict(cache_dir);
+		}
+
+		elf.seek(0);
+	}
+
+	return elf;
+}
+
 std::shared_ptr<lv2_prx> ppu_load_prx(const ppu_prx_object& elf, const std::string& path)
 {
 	// Create new PRX object
@@ -1360,7 +1473,7 @@ void ppu_load_exec(const ppu_exec_object& elf)
 
 		for (const auto& name : load_libs)
 		{
-			const ppu_prx_object obj = decrypt_self(fs::file(lle_dir + name));
+			const ppu_prx_object obj = ppu_decrypt_prx(fs::file(lle_dir + name), lle_dir + name, nullptr);
 
 			if (obj == elf_error::ok)
 			{
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Utilities/VirtualMemory.h"
 #include "Utilities/sysinfo.h"
+#include "Utilities/StrUtil.h"
 #include "Crypto/sha1.h"
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
@@ -163,6 +164,9 @@ extern const ppu_decoder<ppu_interpreter_fast> g_ppu_interpreter_fast([](auto& t
 	}
 });
 
+const ppu_decoder<ppu_itype> s_ppu_itype;
+const ppu_decoder<ppu_iname> s_ppu_iname;
+
 extern void ppu_initialize();
 extern void ppu_initialize(const ppu_module& info);
 static void ppu_initialize2(class jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name, u32 fragment_index, atomic_t<u32>&);
@@ -229,6 +233,28 @@ static bool ppu_check_toc(ppu_thread& ppu, ppu_opcode_t op)
 	return false;
 }
 
+// Executed instruction counters for every instruction address (addr / 4), used with PPU Instruction Histogram
+extern u64* ppu_hist_table()
+{
+	static u64* const s_table = static_cast<u64*>(utils::memory_reserve(0x200000000));
+	return s_table;
+}
+
+// Registered executable ranges and functions (for histogram report)
+struct ppu_hist_info
+{
+	struct func_info
+	{
+		u32 addr;
+		std::string name;
+		std::vector<std::pair<u32, u32>> blocks;
+	};
+
+	shared_mutex mutex;
+	std::vector<std::pair<u32, u32>> ranges;
+	std::vector<func_info> funcs;
+};
+
 extern void ppu_register_range(u32 addr, u32 size)
 {
 	if (!size)
@@ -240,6 +266,17 @@ extern void ppu_register_range(u32 addr, u32 size)
 	// Register executable range at
 	utils::memory_commit(&ppu_ref(addr), size, utils::protection::rw);
 
+	if (g_cfg.core.ppu_histogram)
+	{
+		const auto hist = fxm::get_always<ppu_hist_info>();
+		writer_lock lock(hist->mutex);
+		utils::memory_commit(ppu_hist_table() + addr / 4, size * 2, utils::protection::rw);
+
+		// Counters may be left from the previous run in the same process
+		std::memset(ppu_hist_table() + addr / 4, 0, size * 2);
+		hist->ranges.emplace_back(addr, size);
+	}
+
 	const u32 fallback = ::narrow<u32>(reinterpret_cast<std::uintptr_t>(ppu_fallback));
 
 	size &= ~3; // Loop assumes `size = n * 4`, enforce that by rounding down
@@ -290,6 +327,120 @@ extern void ppu_register_function_at(u32 addr, u32 size, ppu_function_t ptr)
 	}
 }
 
+// Write executed instruction counts per instruction type and per function
+extern void ppu_histogram_report()
+{
+	const auto hist = fxm::get<ppu_hist_info>();
+
+	if (!hist)
+	{
+		return;
+	}
+
+	reader_lock lock(hist->mutex);
+
+	const auto table = ppu_hist_table();
+
+	// Release counters (the table is process-wide and must not carry counts to the next run)
+	auto release = [&]
+	{
+		for (const auto& range : hist->ranges)
+		{
+			// Round to whole pages (neighbouring ranges are released as well)
+			const u64 start = reinterpret_cast<u64>(table + range.first / 4) & -4096;
+			const u64 end = ::align(reinterpret_cast<u64>(table + (range.first + range.second) / 4), 4096);
+			utils::memory_decommit(reinterpret_cast<void*>(start), end - start);
+		}
+	};
+
+	// Instruction type -> (count, encoded name)
+	std::map<u32, std::pair<u64, u64>> types;
+	u64 total = 0;
+
+	for (const auto& range : hist->ranges)
+	{
+		for (u32 addr = range.first; addr < range.first + (range.second & ~3); addr += 4)
+		{
+			if (const u64 count = table[addr / 4])
+			{
+				const u32 op = vm::read32(addr);
+				auto& type = types[s_ppu_itype.decode(op)];
+				type.first += count;
+				type.second = s_ppu_iname.decode(op);
+				total += count;
+			}
+		}
+	}
+
+	if (!total)
+	{
+		release();
+		return;
+	}
+
+	std::vector<std::pair<u64, std::string>> sorted;
+
+	for (const auto& type : types)
+	{
+		// Decode instruction name (6 bits per character)
+		std::string name;
+
+		for (u64 value = type.second.second; value; value >>= 6)
+		{
+			name.insert(name.begin(), static_cast<char>((value & 0x3f) + 0x20));
+		}
+
+		sorted.emplace_back(type.second.first, std::move(name));
+	}
+
+	std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+	std::string out = "Count\tPercent\tInstruction\n";
+
+	for (const auto& type : sorted)
+	{
+		fmt::append(out, "%u\t%.3f\t%s\n", type.first, type.first * 100. / total, type.second);
+	}
+
+	fs::file(fs::get_config_dir() + "ppu_itype_histogram.tsv", fs::rewrite).write(out);
+
+	// Aggregate per function
+	std::vector<std::pair<u64, const ppu_hist_info::func_info*>> funcs;
+
+	for (const auto& func : hist->funcs)
+	{
+		u64 count = 0;
+
+		for (const auto& block : func.blocks)
+		{
+			for (u32 addr = block.first; addr < block.first + block.second; addr += 4)
+			{
+				count += table[addr / 4];
+			}
+		}
+
+		if (count)
+		{
+			funcs.emplace_back(count, &func);
+		}
+	}
+
+	std::sort(funcs.begin(), funcs.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+	out = "Count\tPercent\tAddress\tModule\n";
+
+	for (const auto& func : funcs)
+	{
+		fmt::append(out, "%u\t%.3f\t0x%08x\t%s\n", func.first, func.first * 100. / total, func.second->addr, func.second->name);
+	}
+
+	fs::file(fs::get_config_dir() + "ppu_func_histogram.tsv", fs::rewrite).write(out);
+
+	LOG_SUCCESS(PPU, "Instruction histogram: %u instructions executed (%u types, %u functions)", total, sorted.size(), funcs.size());
+
+	release();
+}
+
 // Breakpoint entry point
 static bool ppu_break(ppu_thread& ppu, ppu_opcode_t op)
 {
@@ -343,21 +494,95 @@ void ppu_thread::on_spawn()
 	}
 }
 
+// Stacks (with the gap) of destroyed PPU threads kept for reuse
+static struct ppu_stack_cache
+{
+	static constexpr std::size_t max_count = 16;
+
+	std::mutex mutex;
+
+	// Stack memory block the cached stacks belong to
+	std::weak_ptr<vm::block_t> block;
+
+	// Pairs of stack size and stack base
+	std::vector<std::pair<u32, u32>> stacks;
+
+	// Get cached stack base of the specified size (or 0)
+	u32 pop(u32 size)
+	{
+		const auto current = vm::get(vm::stack);
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (block.owner_before(current) || current.owner_before(block))
+		{
+			// Memory was reinitialized, forget everything
+			block = current;
+			stacks.clear();
+			return 0;
+		}
+
+		for (auto it = stacks.begin(); it != stacks.end(); it++)
+		{
+			if (it->first == size)
+			{
+				const u32 addr = it->second;
+				stacks.erase(it);
+				return addr;
+			}
+		}
+
+		return 0;
+	}
+
+	// Try to cache stack base of the specified size
+	bool push(u32 size, u32 addr)
+	{
+		const auto current = vm::get(vm::stack);
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (!current || block.owner_before(current) || current.owner_before(block) || stacks.size() >= max_count)
+		{
+			return false;
+		}
+
+		stacks.emplace_back(size, addr);
+		return true;
+	}
+} s_ppu_stacks;
+
+bool ppu_thread::is_pooled() const
+{
+	// Guest threads are often created and destroyed frequently
+	return true;
+}
+
 void ppu_thread::on_init(const std::shared_ptr<void>& _this)
 {
 	if (!stack_addr)
 	{
-		// Allocate stack + gap between stacks
-		auto new_stack_base = vm::alloc(stack_size + 4096, vm::stack);
-		if (!new_stack_base)
+		if (const u32 cached_base = s_ppu_stacks.pop(stack_size))
 		{
-			fmt::throw_exception("Out of stack memory (size=0x%x)" HERE, stack_size);
+			const_cast<u32&>(stack_addr) = cached_base + 4096;
+
+			// Reused stack must look like a fresh allocation
+			std::memset(vm::base(stack_addr), 0, stack_size);
 		}
+		else
+		{
+			// Allocate stack + gap between stacks
+			auto new_stack_base = vm::alloc(stack_size + 4096, vm::stack);
+			if (!new_stack_base)
+			{
+				fmt::throw_exception("Out of stack memory (size=0x%x)" HERE, stack_size);
+			}
 
-		const_cast<u32&>(stack_addr) = new_stack_base + 4096;
+			const_cast<u32&>(stack_addr) = new_stack_base + 4096;
 
-		// Make the gap inaccessible
-		vm::page_protect(new_stack_base, 4096, 0, 0, vm::page_readable + vm::page_writable);
+			// Make the gap inaccessible
+			vm::page_protect(new_stack_base, 4096, 0, 0, vm::page_readable + vm::page_writable);
+		}
 
 		gpr[1] = ::align(stack_addr + stack_size, 0x200) - 0x200;
 
@@ -439,6 +664,62 @@ std::string ppu_thread::get_name() const
 	return fmt::format("PPU[0x%x] Thread (%s)", id, m_name);
 }
 
+ppu_thread_context ppu_thread::save_context() const
+{
+	static_assert(sizeof(cr) == sizeof(ppu_thread_context::cr), "ppu_thread_context: CR size mismatch");
+	static_assert(sizeof(fpscr) == sizeof(ppu_thread_context::fpscr), "ppu_thread_context: FPSCR size mismatch");
+
+	ppu_thread_context ctx{};
+	ctx.version = ppu_thread_context::current_version;
+	ctx.cia = cia;
+	std::memcpy(ctx.cr, cr, sizeof(ctx.cr));
+	ctx.vrsave = vrsave;
+	ctx.prio = prio;
+	std::memcpy(ctx.fpscr, &fpscr, sizeof(ctx.fpscr));
+	ctx.xer_so = xer.so;
+	ctx.xer_ov = xer.ov;
+	ctx.xer_ca = xer.ca;
+	ctx.xer_cnt = xer.cnt;
+	ctx.sat = sat;
+	ctx.nj = nj;
+	ctx.lr = lr;
+	ctx.ctr = ctr;
+	std::memcpy(ctx.gpr, gpr, sizeof(gpr));
+	std::memcpy(ctx.fpr, fpr, sizeof(fpr));
+	std::memcpy(ctx.vr, vr, sizeof(vr));
+	return ctx;
+}
+
+bool ppu_thread::load_context(const ppu_thread_context& ctx)
+{
+	if (ctx.version != ppu_thread_context::current_version)
+	{
+		LOG_ERROR(PPU, "Context version mismatch (%u, expected %u)", ctx.version, ppu_thread_context::current_version);
+		return false;
+	}
+
+	cia = ctx.cia;
+	std::memcpy(cr, ctx.cr, sizeof(ctx.cr));
+	vrsave = ctx.vrsave;
+	prio = ctx.prio;
+	std::memcpy(&fpscr, ctx.fpscr, sizeof(ctx.fpscr));
+	xer.so = ctx.xer_so != 0;
+	xer.ov = ctx.xer_ov != 0;
+	xer.ca = ctx.xer_ca != 0;
+	xer.cnt = ctx.xer_cnt;
+	sat = ctx.sat != 0;
+	nj = ctx.nj != 0;
+	lr = ctx.lr;
+	ctr = ctx.ctr;
+	std::memcpy(gpr, ctx.gpr, sizeof(gpr));
+	std::memcpy(fpr, ctx.fpr, sizeof(fpr));
+	std::memcpy(vr, ctx.vr, sizeof(vr));
+
+	// Reservation can't survive restore
+	raddr = 0;
+	return true;
+}
+
 std::string ppu_thread::dump() const
 {
 	std::string ret = cpu_thread::dump();
@@ -603,6 +884,9 @@ void ppu_thread::exec_task()
 	using func_t = decltype(&ppu_interpreter::UNK);
 	func_t func0, func1, func2, func3, func4, func5;
 
+	// Instruction counters (instrumentation)
+	const auto hist = g_cfg.core.ppu_histogram ? ppu_hist_table() : nullptr;
+
 	while (true)
 	{
 		if (UNLIKELY(test(state)))
@@ -615,6 +899,15 @@ void ppu_thread::exec_task()
 			continue;
 		}
 
+		if (UNLIKELY(hist))
+		{
+			// Count and execute single instruction
+			const u32 op = *reinterpret_cast<const be_t<u32>*>(base + cia);
+			atomic_storage<u64>::fetch_inc(hist[cia / 4]);
+			if (reinterpret_cast<func_t>((std::uintptr_t)ppu_ref(cia))(*this, {op})) { cia += 4; }
+			continue;
+		}
+
 		if (cia % 16 || !s_use_ssse3)
 		{
 			// Unaligned
@@ -677,7 +970,7 @@ void ppu_thread::exec_task()
 
 ppu_thread::~ppu_thread()
 {
-	if (stack_addr)
+	if (stack_addr && !s_ppu_stacks.push(stack_size, stack_addr - 4096))
 	{
 		vm::dealloc_verbose_nothrow(stack_addr - 4096, vm::stack);
 	}
@@ -870,8 +1163,6 @@ void ppu_thread::stack_pop_verbose(u32 addr, u32 size) noexcept
 	LOG_ERROR(PPU, "Invalid thread" HERE);
 }
 
-const ppu_decoder<ppu_itype> s_ppu_itype;
-
 extern u64 get_timebased_time();
 extern ppu_function_t ppu_get_syscall(u64 code);
 
@@ -1019,6 +1310,81 @@ extern bool ppu_stdcx(ppu_thread& ppu, u32 addr, u64 reg_value)
 	return result;
 }
 
+// Atomic update of the word (replaces lwarx/stwcx. loop), returns old value; func returns false if nothing is stored
+template <typename F>
+static u32 ppu_atomic_update(ppu_thread& ppu, u32 addr, F&& func)
+{
+	atomic_be_t<u32>& data = vm::_ref<atomic_be_t<u32>>(addr);
+
+	// Reservation is lost as after stwcx.
+	ppu.raddr = 0;
+
+	u32 old;
+
+	const auto op = [&](be_t<u32>& value)
+	{
+		old = value;
+		return func(value);
+	};
+
+	if (s_use_rtm && utils::transaction_enter())
+	{
+		if (!vm::reader_lock{vm::try_to_lock})
+		{
+			_xabort(0);
+		}
+
+		if (data.atomic_op(op))
+		{
+			vm::reservation_update(addr, sizeof(u32));
+			vm::notify(addr, sizeof(u32));
+		}
+
+		_xend();
+		return old;
+	}
+
+	vm::writer_lock lock(0);
+
+	if (data.atomic_op(op))
+	{
+		vm::reservation_update(addr, sizeof(u32));
+		vm::notify(addr, sizeof(u32));
+	}
+
+	return old;
+}
+
+static u32 ppu_atomic_add(ppu_thread& ppu, u32 addr, u32 value)
+{
+	return ppu_atomic_update(ppu, addr, [&](be_t<u32>& data) { data += value; return true; });
+}
+
+static u32 ppu_atomic_sub(ppu_thread& ppu, u32 addr, u32 value)
+{
+	return ppu_atomic_update(ppu, addr, [&](be_t<u32>& data) { data -= value; return true; });
+}
+
+static u32 ppu_atomic_or(ppu_thread& ppu, u32 addr, u32 value)
+{
+	return ppu_atomic_update(ppu, addr, [&](be_t<u32>& data) { data |= value; return true; });
+}
+
+static u32 ppu_atomic_and(ppu_thread& ppu, u32 addr, u32 value)
+{
+	return ppu_atomic_update(ppu, addr, [&](be_t<u32>& data) { data &= value; return true; });
+}
+
+static u32 ppu_atomic_swap(ppu_thread& ppu, u32 addr, u32 value)
+{
+	return ppu_atomic_update(ppu, addr, [&](be_t<u32>& data) { data = value; return true; });
+}
+
+static u32 ppu_atomic_cas(ppu_thread& ppu, u32 addr, u32 cmp, u32 value)
+{
+	return ppu_atomic_update(ppu, addr, [&](be_t<u32>& data) { return data == cmp ? (data = value, true) : false; });
+}
+
 static bool adde_carry(u64 a, u64 b, bool c)
 {
 #ifdef _MSC_VER
@@ -1056,8 +1422,72 @@ extern void ppu_initialize()
 	}
 }
 
+#ifdef LLVM_AVAILABLE
+// Content-defined fragment boundary: depends only on the instructions of the function, so that a local change
+// (patch, different analysis result) doesn't shift boundaries and names of all following fragments
+static bool ppu_fragment_anchor(const ppu_function& func, bool reloc)
+{
+	// Ignore 16-bit immediates in relocatable modules (ADDR16 relocations depend on the load address)
+	const u32 mask = reloc ? 0xffff0000 : 0xffffffff;
+
+	// FNV-1a over instruction words
+	u64 hash = 0xcbf29ce484222325;
+
+	for (u32 i = 0; i < func.size / 4; i++)
+	{
+		hash ^= vm::ps3::read32(func.addr + i * 4) & mask;
+		hash *= 0x100000001b3;
+	}
+
+	return (hash * 0x9e3779b97f4a7c15 >> 60) == 0;
+}
+
+// Write the list of object files composing the module and remove stale fragments listed previously
+// Each build configuration (tag) has its own manifest, objects of other configurations are never removed
+static void ppu_update_manifest(const std::string& cache_path, const std::string& name, const std::string& tag, const std::vector<std::string>& obj_list)
+{
+	const std::string path = cache_path + "v2-" + (name.empty() ? "main" : name) + "-" + tag + ".manifest";
+	const std::string suffix = "-" + tag + ".obj";
+
+	if (const fs::file old{path})
+	{
+		for (const auto& obj_name : fmt::split(old.to_string(), {"\n"}))
+		{
+			if (std::find(obj_list.begin(), obj_list.end(), obj_name) != obj_list.end() || obj_name.find_first_of("/\\") != std::string::npos)
+			{
+				continue;
+			}
+
+			if (obj_name.size() > suffix.size() && obj_name.compare(obj_name.size() - suffix.size(), suffix.size(), suffix) == 0)
+			{
+				LOG_NOTICE(PPU, "LLVM: Removing stale module %s", obj_name);
+				fs::remove_file(cache_path + obj_name);
+			}
+		}
+	}
+
+	fs::file(path, fs::rewrite).write(fmt::merge(obj_list, "\n"));
+}
+#endif
+
 extern void ppu_initialize(const ppu_module& info)
 {
+	if (g_cfg.core.ppu_histogram)
+	{
+		// Remember function layout for the histogram report
+		const auto hist = fxm::get_always<ppu_hist_info>();
+		writer_lock lock(hist->mutex);
+
+		for (const auto& func : info.funcs)
+		{
+			if (!func.size) continue;
+
+			ppu_hist_info::func_info entry{func.addr, info.name.empty() ? "main" : info.name};
+			entry.blocks.assign(func.blocks.begin(), func.blocks.end());
+			hist->funcs.emplace_back(std::move(entry));
+		}
+	}
+
 	if (g_cfg.core.ppu_decoder != ppu_decoder_type::llvm)
 	{
 		// Temporarily
@@ -1097,6 +1527,12 @@ extern void ppu_initialize(const ppu_module& info)
 			{ "__ldarx", (u64)&ppu_ldarx },
 			{ "__stwcx", (u64)&ppu_stwcx },
 			{ "__stdcx", (u64)&ppu_stdcx },
+			{ "__atomic_add", (u64)&ppu_atomic_add },
+			{ "__atomic_sub", (u64)&ppu_atomic_sub },
+			{ "__atomic_or", (u64)&ppu_atomic_or },
+			{ "__atomic_and", (u64)&ppu_atomic_and },
+			{ "__atomic_swap", (u64)&ppu_atomic_swap },
+			{ "__atomic_cas", (u64)&ppu_atomic_cas },
 			{ "__vexptefp", (u64)&sse_exp2_ps },
 			{ "__vlogefp", (u64)&sse_log2_ps },
 			{ "__vperm", s_use_ssse3 ? (u64)&sse_altivec_vperm : (u64)&sse_altivec_vperm_v0 },
@@ -1185,7 +1621,13 @@ extern void ppu_initialize(const ppu_module& info)
 
 	atomic_t<u32> fragment_sync{0};
 
-	u32 fragment_count{0};
+	// Object files composing this module (written to the manifest)
+	std::vector<std::string> obj_list;
+
+	u32 obj_reused{0};
+
+	// Build configuration tag of object files (CPU and instrumentation)
+	std::string obj_tag;
 
 	while (jit_mod.vars.empty() && fpos < info.funcs.size())
 	{
@@ -1193,6 +1635,12 @@ extern void ppu_initialize(const ppu_module& info)
 		if (!jit)
 		{
 			jit = std::make_shared<jit_compiler>(s_link_table, g_cfg.core.llvm_cpu);
+			obj_tag = jit->cpu();
+
+			if (g_cfg.core.ppu_histogram)
+			{
+				obj_tag += "-hist";
+			}
 		}
 
 		// First function in current module part
@@ -1218,6 +1666,11 @@ extern void ppu_initialize(const ppu_module& info)
 				break;
 			}
 
+			if (bsize >= 64 * 1024 && ppu_fragment_anchor(func, reloc != 0))
+			{
+				break;
+			}
+
 			for (auto&& block : func.blocks)
 			{
 				bsize += block.second;
@@ -1291,8 +1744,14 @@ extern void ppu_initialize(const ppu_module& info)
 				sha1_update(&ctx, reinterpret_cast<const u8*>(&forced_upd), sizeof(forced_upd));
 			}
 
+			if (g_cfg.core.ppu_histogram)
+			{
+				// Instrumented code must not be mixed with normal code
+				sha1_update(&ctx, reinterpret_cast<const u8*>("__hptr"), 6);
+			}
+
 			sha1_finish(&ctx, output);
-			fmt::append(obj_name, "-%016X-%s.obj", reinterpret_cast<be_t<u64>&>(output), jit->cpu());
+			fmt::append(obj_name, "-%016X-%s.obj", reinterpret_cast<be_t<u64>&>(output), obj_tag);
 		}
 
 		if (Emu.IsStopped())
@@ -1309,6 +1768,13 @@ extern void ppu_initialize(const ppu_module& info)
 			globals.emplace_back(fmt::format("__seg%u_%x", i, suffix), info.segs[i].addr);
 		}
 
+		if (g_cfg.core.ppu_histogram)
+		{
+			globals.emplace_back(fmt::format("__hptr%x", suffix), (u64)ppu_hist_table());
+		}
+
+		obj_list.emplace_back(obj_name);
+
 		// Check object file
 		if (fs::is_file(cache_path + obj_name))
 		{
@@ -1316,6 +1782,7 @@ extern void ppu_initialize(const ppu_module& info)
 			jit->add(cache_path + obj_name);
 
 			LOG_SUCCESS(PPU, "LLVM: Loaded module %s", obj_name);
+			obj_reused++;
 			continue;
 		}
 
@@ -1367,6 +1834,13 @@ extern void ppu_initialize(const ppu_module& info)
 	// Jit can be null if the loop doesn't ever enter.
 	if (jit && jit_mod.vars.empty())
 	{
+		ppu_update_manifest(cache_path, info.name, obj_tag, obj_list);
+
+		if (obj_reused != obj_list.size())
+		{
+			LOG_NOTICE(PPU, "LLVM: Module %s: %u of %u fragments reused", info.name, obj_reused, obj_list.size());
+		}
+
 		semaphore_lock lock(jmutex);
 		jit->fin();
 
@@ -1429,6 +1903,11 @@ extern void ppu_initialize(const ppu_module& info)
 			{
 				*jit_mod.vars[index++] = seg.addr;
 			}
+
+			if (g_cfg.core.ppu_histogram)
+			{
+				*jit_mod.vars[index++] = (u64)ppu_hist_table();
+			}
 		}
 	}
 #else
@@ -23,6 +23,30 @@ enum class ppu_syscall_code : u64
 {
 };
 
+// PPU register state (trivially copyable, stored next to vm block dumps for checkpoints)
+struct ppu_thread_context
+{
+	static const u32 current_version = 1;
+
+	u32 version;
+	u32 cia;
+	u32 vrsave;
+	u32 prio;
+	u8 cr[32]; // Unpacked
+	u8 fpscr[32]; // Unpacked
+	u8 xer_so;
+	u8 xer_ov;
+	u8 xer_ca;
+	u8 xer_cnt;
+	u8 sat;
+	u8 nj;
+	u64 lr;
+	u64 ctr;
+	u64 gpr[32];
+	f64 fpr[32];
+	v128 vr[32];
+};
+
 class ppu_thread : public cpu_thread
 {
 public:
@@ -32,6 +56,7 @@ public:
 
 	virtual void on_spawn() override;
 	virtual void on_init(const std::shared_ptr<void>&) override;
+	virtual bool is_pooled() const override;
 	virtual std::string get_name() const override;
 	virtual std::string dump() const override;
 	virtual void cpu_task() override;
@@ -148,10 +173,21 @@ public:
 	cmd64 cmd_get(u32 index) { return cmd_queue[cmd_queue.peek() + index].load(); }
 
 	u64 start_time{0}; // Sleep start timepoint
+
+	// Scheduler run queue links (lv2_obj::g_mutex must be locked)
+	ppu_thread* sched_prev{};
+	ppu_thread* sched_next{};
+	u32 sched_level{~0u}; // Run queue priority level (-1 if not queued)
 	const char* last_function{}; // Last function name for diagnosis, optimized for speed.
 
 	const std::string m_name; // Thread name
 
+	// Save register state (thread must be paused with snapshot_pause() or be the current thread)
+	ppu_thread_context save_context() const;
+
+	// Restore register state, returns false on version mismatch
+	bool load_context(const ppu_thread_context&);
+
 	be_t<u64>* get_stack_arg(s32 i, u64 align = alignof(u64));
 	void exec_task();
 	void fast_call(u32 addr, u32 rtoc);
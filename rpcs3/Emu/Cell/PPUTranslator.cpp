@@ -3,6 +3,8 @@
 #include "PPUTranslator.h"
 #include "PPUThread.h"
 #include "PPUInterpreter.h"
+#include "Emu/System.h"
+#include "Utilities/sysinfo.h"
 
 #include "../Utilities/Log.h"
 #include <algorithm>
@@ -10,11 +12,13 @@
 using namespace llvm;
 
 const ppu_decoder<PPUTranslator> s_ppu_decoder;
+const ppu_decoder<ppu_itype> s_ppu_itype;
 
 PPUTranslator::PPUTranslator(LLVMContext& context, Module* module, const ppu_module& info)
 	: cpu_translator(context, module, false)
 	, m_info(info)
 	, m_pure_attr(AttributeSet::get(m_context, AttributeSet::FunctionIndex, {Attribute::NoUnwind, Attribute::ReadNone}))
+	, m_use_ssse3(utils::has_ssse3())
 {
 	// There is no weak linkage on JIT, so let's create variables with different names for each module part
 	const u32 gsuffix = m_info.name.empty() ? info.funcs[0].addr : info.funcs[0].addr - m_info.segs[0].addr;
@@ -49,6 +53,14 @@ PPUTranslator::PPUTranslator(LLVMContext& context, Module* module, const ppu_mod
 	m_call->setInitializer(ConstantPointerNull::get(cast<PointerType>(m_call->getType()->getPointerElementType())));
 	m_call->setExternallyInitialized(true);
 
+	if (g_cfg.core.ppu_histogram)
+	{
+		// Instruction counters
+		m_hist = new GlobalVariable(*module, ArrayType::get(GetType<u64>(), 0x40000000)->getPointerTo(), true, GlobalValue::ExternalLinkage, 0, fmt::format("__hptr%x", gsuffix));
+		m_hist->setInitializer(ConstantPointerNull::get(cast<PointerType>(m_hist->getType()->getPointerElementType())));
+		m_hist->setExternallyInitialized(true);
+	}
+
 	const auto md_name = MDString::get(m_context, "branch_weights");
 	const auto md_low = ValueAsMetadata::get(ConstantInt::get(GetType<u32>(), 1));
 	const auto md_high = ValueAsMetadata::get(ConstantInt::get(GetType<u32>(), 666));
@@ -156,8 +168,10 @@ Function* PPUTranslator::Translate(const ppu_function& info)
 			RegLoad(m_lr);
 		}
 
+		m_end = block.first + block.second - base;
+
 		// Process the instructions
-		for (m_addr = block.first - base; m_addr < block.first + block.second - base; m_addr += 4)
+		for (m_addr = block.first - base; m_addr < m_end; m_addr += 4)
 		{
 			if (m_body->getTerminator())
 			{
@@ -176,6 +190,13 @@ Function* PPUTranslator::Translate(const ppu_function& info)
 				m_rel = nullptr;
 			}
 
+			if (m_hist)
+			{
+				// Increment instruction counter
+				const auto ptr = m_ir->CreateGEP(m_ir->CreateLoad(m_hist), {m_ir->getInt64(0), m_ir->CreateLShr(GetAddr(), 2)});
+				m_ir->CreateAtomicRMW(AtomicRMWInst::Add, ptr, m_ir->getInt64(1), AtomicOrdering::Monotonic);
+			}
+
 			const u32 op = vm::ps3::read32(vm::cast(m_addr + base));
 			(this->*(s_ppu_decoder.decode(op)))({op});
 
@@ -504,6 +525,187 @@ void PPUTranslator::UseCondition(MDNode* hint, Value* cond)
 	}
 }
 
+bool PPUTranslator::AtomicLoop(ppu_opcode_t op)
+{
+	// Recognized loops (A = address, D = loaded value, S = operand, T = stored value (may be D), E = comparand):
+	//   lwarx D; add/subf/addi/or/ori/and T, D, S; stwcx. T; bne- loop
+	//   lwarx D; stwcx. S; bne- loop
+	//   lwarx D; cmpw/cmplw/cmpwi/cmplwi cr0, D, E; bne- exit; stwcx. S; bne- loop
+	const u64 base = m_reloc ? m_reloc->addr : 0;
+	ppu_opcode_t ops[5];
+	ppu_itype::type types[5];
+
+	for (u32 i = 1; i < 5; i++)
+	{
+		if (m_addr + i * 4 >= m_end)
+		{
+			// Don't look past the end of the current block
+			ops[i].opcode = 0;
+			types[i] = ppu_itype::UNK;
+			continue;
+		}
+
+		if (m_relocs.count(m_addr + base + i * 4))
+		{
+			return false;
+		}
+
+		ops[i].opcode = vm::ps3::read32(vm::cast(m_addr + base + i * 4));
+		types[i] = s_ppu_itype.decode(ops[i].opcode);
+	}
+
+	const u32 rd = op.rd;
+
+	if (rd == op.ra || rd == op.rb)
+	{
+		return false;
+	}
+
+	// Check stwcx. to the same address (storing D itself is only allowed if it's recomputed in between)
+	const auto is_store = [&](u32 i, bool allow_rd = false)
+	{
+		return types[i] == ppu_itype::STWCX && ops[i].ra == op.ra && ops[i].rb == op.rb && (allow_rd || ops[i].rs != rd);
+	};
+
+	// Check bne- cr0 (optionally to the specified target)
+	const auto is_bne = [&](u32 i, u64 target)
+	{
+		const u64 dest = m_addr + i * 4 + ops[i].bt14;
+		return types[i] == ppu_itype::BC && (ops[i].bo & 0x1c) == 0x4 && ops[i].bi == 2 && !ops[i].aa && !ops[i].lk && (!target || dest == target) ? dest : 0;
+	};
+
+	// Effective address
+	const auto get_addr = [&]()
+	{
+		return op.ra ? m_ir->CreateAdd(GetGpr(op.ra), GetGpr(op.rb)) : GetGpr(op.rb);
+	};
+
+	if (is_store(1) && is_bne(2, m_addr))
+	{
+		SetGpr(rd, Call(GetType<u32>(), "__atomic_swap", m_thread, get_addr(), GetGpr(ops[1].rs, 32)));
+		SetCrField(0, m_ir->getFalse(), m_ir->getFalse(), m_ir->getTrue());
+		FlushRegisters();
+		CallFunction(m_addr + 12);
+		return true;
+	}
+
+	if (is_store(2, true) && is_bne(3, m_addr))
+	{
+		// T may be D (lwarx rX; addi rX, rX, 1; stwcx. rX): D is set to the old value, then recomputed below
+		const ppu_opcode_t mid = ops[1];
+		const u32 rt = ops[2].rs;
+
+		// Find operation and its operand: register (must not be clobbered by the loop) or immediate
+		u32 rs = rd;
+		s32 imm = 0;
+		const char* func = "__atomic_add";
+
+		switch (types[1])
+		{
+		case ppu_itype::ADD:
+		{
+			if (mid.rd != rt || mid.oe || mid.rc) return false;
+			rs = mid.ra == rd ? mid.rb : mid.rb == rd ? mid.ra : rd;
+			break;
+		}
+		case ppu_itype::SUBF:
+		{
+			// rt = D - S
+			if (mid.rd != rt || mid.oe || mid.rc || mid.rb != rd) return false;
+			rs = mid.ra;
+			func = "__atomic_sub";
+			break;
+		}
+		case ppu_itype::ADDI:
+		{
+			if (mid.rd != rt || mid.ra != rd || !rd) return false;
+			rs = -1;
+			imm = mid.simm16;
+			break;
+		}
+		case ppu_itype::OR:
+		case ppu_itype::AND:
+		{
+			if (mid.ra != rt || mid.rc) return false;
+			rs = mid.rs == rd ? mid.rb : mid.rb == rd ? mid.rs : rd;
+			func = types[1] == ppu_itype::OR ? "__atomic_or" : "__atomic_and";
+			break;
+		}
+		case ppu_itype::ORI:
+		{
+			if (mid.ra != rt || mid.rs != rd) return false;
+			rs = -1;
+			imm = mid.uimm16;
+			func = "__atomic_or";
+			break;
+		}
+		default:
+		{
+			return false;
+		}
+		}
+
+		if (rs == rd || rs == rt || rt == op.ra || rt == op.rb)
+		{
+			return false;
+		}
+
+		const auto value = rs == -1 ? m_ir->getInt32(imm) : GetGpr(rs, 32);
+		SetGpr(rd, Call(GetType<u32>(), func, m_thread, get_addr(), value));
+
+		// Compute the stored value normally
+		(this->*(s_ppu_decoder.decode(mid.opcode)))(mid);
+		SetCrField(0, m_ir->getFalse(), m_ir->getFalse(), m_ir->getTrue());
+		FlushRegisters();
+		CallFunction(m_addr + 16);
+		return true;
+	}
+
+	if (const u64 exit = is_bne(2, 0))
+	{
+		const ppu_opcode_t cmp = ops[1];
+
+		if (exit == m_addr || !is_store(3) || !is_bne(4, m_addr) || cmp.crfd != 0 || cmp.ra != rd)
+		{
+			return false;
+		}
+
+		if (cmp.l10 || ((types[1] == ppu_itype::CMP || types[1] == ppu_itype::CMPL) && cmp.rb == rd))
+		{
+			return false;
+		}
+
+		Value* value;
+
+		switch (types[1])
+		{
+		case ppu_itype::CMP:
+		case ppu_itype::CMPL: value = GetGpr(cmp.rb, 32); break;
+		case ppu_itype::CMPI: value = m_ir->getInt32(cmp.simm16); break;
+		case ppu_itype::CMPLI: value = m_ir->getInt32(cmp.uimm16); break;
+		default: return false;
+		}
+
+		SetGpr(rd, Call(GetType<u32>(), "__atomic_cas", m_thread, get_addr(), value, GetGpr(ops[3].rs, 32)));
+
+		// Compare normally: on success, CR0 is the same as set by stwcx.
+		(this->*(s_ppu_decoder.decode(cmp.opcode)))(cmp);
+		const auto cond = GetCrb(2);
+		FlushRegisters();
+
+		const auto done = BasicBlock::Create(m_context, "__done", m_function);
+		const auto fail = BasicBlock::Create(m_context, "__fail", m_function);
+		m_ir->CreateCondBr(cond, done, fail);
+		m_ir->SetInsertPoint(fail);
+		CallFunction(exit);
+		m_ir->SetInsertPoint(done);
+		CallFunction(m_addr + 20);
+		return true;
+	}
+
+	return false;
+}
+
 llvm::Value* PPUTranslator::GetMemory(llvm::Value* addr, llvm::Type* type)
 {
 	return m_ir->CreateBitCast(m_ir->CreateGEP(m_base_loaded, {m_ir->getInt64(0), addr}), type->getPointerTo());
@@ -576,24 +778,18 @@ void PPUTranslator::VADDFP(ppu_opcode_t op)
 
 void PPUTranslator::VADDSBS(ppu_opcode_t op)
 {
-	const auto a = get_vr<s8[16]>(op.va);
-	const auto b = get_vr<s8[16]>(op.vb);
-	const auto s = eval(a + b);
-	const auto z = eval((a >> 7) ^ 0x7f);
-	const auto x = eval(scarry(a, b, s) >> 7);
-	set_vr(op.vd, eval(merge(x, z, s)));
-	SetSat(IsNotZero(x.value));
+	const auto ab = GetVrs(VrType::vi8, op.va, op.vb);
+	const auto r = Call(GetType<u8[16]>(), m_pure_attr, "llvm.x86.sse2.padds.b", ab[0], ab[1]);
+	SetVr(op.vd, r);
+	SetSat(IsNotZero(m_ir->CreateXor(r, m_ir->CreateAdd(ab[0], ab[1]))));
 }
 
 void PPUTranslator::VADDSHS(ppu_opcode_t op)
 {
-	const auto a = get_vr<s16[8]>(op.va);
-	const auto b = get_vr<s16[8]>(op.vb);
-	const auto s = eval(a + b);
-	const auto z = eval((a >> 15) ^ 0x7fff);
-	const auto x = eval(scarry(a, b, s) >> 15);
-	set_vr(op.vd, eval(merge(x, z, s)));
-	SetSat(IsNotZero(x.value));
+	const auto ab = GetVrs(VrType::vi16, op.va, op.vb);
+	const auto r = Call(GetType<u16[8]>(), m_pure_attr, "llvm.x86.sse2.padds.w", ab[0], ab[1]);
+	SetVr(op.vd, r);
+	SetSat(IsNotZero(m_ir->CreateXor(r, m_ir->CreateAdd(ab[0], ab[1]))));
 }
 
 void PPUTranslator::VADDSWS(ppu_opcode_t op)
@@ -616,12 +812,10 @@ void PPUTranslator::VADDUBM(ppu_opcode_t op)
 
 void PPUTranslator::VADDUBS(ppu_opcode_t op)
 {
-	const auto a = get_vr<s8[16]>(op.va);
-	const auto b = get_vr<s8[16]>(op.vb);
-	const auto s = eval(a + b);
-	const auto x = eval(ucarry(a, b, s) >> 7);
-	set_vr(op.vd, eval(s | x));
-	SetSat(IsNotZero(x.value));
+	const auto ab = GetVrs(VrType::vi8, op.va, op.vb);
+	const auto r = Call(GetType<u8[16]>(), m_pure_attr, "llvm.x86.sse2.paddus.b", ab[0], ab[1]);
+	SetVr(op.vd, r);
+	SetSat(IsNotZero(m_ir->CreateXor(r, m_ir->CreateAdd(ab[0], ab[1]))));
 }
 
 void PPUTranslator::VADDUHM(ppu_opcode_t op)
@@ -633,12 +827,10 @@ void PPUTranslator::VADDUHM(ppu_opcode_t op)
 
 void PPUTranslator::VADDUHS(ppu_opcode_t op)
 {
-	const auto a = get_vr<s16[8]>(op.va);
-	const auto b = get_vr<s16[8]>(op.vb);
-	const auto s = eval(a + b);
-	const auto x = eval(ucarry(a, b, s) >> 15);
-	set_vr(op.vd, eval(s | x));
-	SetSat(IsNotZero(x.value));
+	const auto ab = GetVrs(VrType::vi16, op.va, op.vb);
+	const auto r = Call(GetType<u16[8]>(), m_pure_attr, "llvm.x86.sse2.paddus.w", ab[0], ab[1]);
+	SetVr(op.vd, r);
+	SetSat(IsNotZero(m_ir->CreateXor(r, m_ir->CreateAdd(ab[0], ab[1]))));
 }
 
 void PPUTranslator::VADDUWM(ppu_opcode_t op)
@@ -1167,6 +1359,17 @@ void PPUTranslator::VOR(ppu_opcode_t op)
 void PPUTranslator::VPERM(ppu_opcode_t op)
 {
 	const auto abc = GetVrs(VrType::vi8, op.va, op.vb, op.vc);
+
+	if (m_use_ssse3)
+	{
+		// Select bytes from a (index > 15) or b (reversed byte order)
+		const auto index = m_ir->CreateAnd(m_ir->CreateNot(abc[2]), 0x1f);
+		const auto sa = Call(GetType<u8[16]>(), m_pure_attr, "llvm.x86.ssse3.pshuf.b.128", abc[0], index);
+		const auto sb = Call(GetType<u8[16]>(), m_pure_attr, "llvm.x86.ssse3.pshuf.b.128", abc[1], index);
+		SetVr(op.vd, m_ir->CreateSelect(m_ir->CreateICmpUGT(index, ConstantVector::getSplat(16, m_ir->getInt8(0xf))), sa, sb));
+		return;
+	}
+
 	SetVr(op.vd, Call(GetType<u8[16]>(), m_pure_attr, "__vperm", abc[0], abc[1], abc[2]));
 }
 
@@ -1458,24 +1661,18 @@ void PPUTranslator::VSUBFP(ppu_opcode_t op)
 
 void PPUTranslator::VSUBSBS(ppu_opcode_t op)
 {
-	const auto a = get_vr<s8[16]>(op.va);
-	const auto b = get_vr<s8[16]>(op.vb);
-	const auto d = eval(a - b);
-	const auto z = eval((a >> 7) ^ 0x7f);
-	const auto x = eval(sborrow(a, b, d) >> 7);
-	set_vr(op.vd, eval(merge(x, z, d)));
-	SetSat(IsNotZero(x.value));
+	const auto ab = GetVrs(VrType::vi8, op.va, op.vb);
+	const auto r = Call(GetType<u8[16]>(), m_pure_attr, "llvm.x86.sse2.psubs.b", ab[0], ab[1]);
+	SetVr(op.vd, r);
+	SetSat(IsNotZero(m_ir->CreateXor(r, m_ir->CreateSub(ab[0], ab[1]))));
 }
 
 void PPUTranslator::VSUBSHS(ppu_opcode_t op)
 {
-	const auto a = get_vr<s16[8]>(op.va);
-	const auto b = get_vr<s16[8]>(op.vb);
-	const auto d = eval(a - b);
-	const auto z = eval((a >> 15) ^ 0x7fff);
-	const auto x = eval(sborrow(a, b, d) >> 15);
-	set_vr(op.vd, eval(merge(x, z, d)));
-	SetSat(IsNotZero(x.value));
+	const auto ab = GetVrs(VrType::vi16, op.va, op.vb);
+	const auto r = Call(GetType<u16[8]>(), m_pure_attr, "llvm.x86.sse2.psubs.w", ab[0], ab[1]);
+	SetVr(op.vd, r);
+	SetSat(IsNotZero(m_ir->CreateXor(r, m_ir->CreateSub(ab[0], ab[1]))));
 }
 
 void PPUTranslator::VSUBSWS(ppu_opcode_t op)
@@ -1498,12 +1695,10 @@ void PPUTranslator::VSUBUBM(ppu_opcode_t op)
 
 void PPUTranslator::VSUBUBS(ppu_opcode_t op)
 {
-	const auto a = get_vr<s8[16]>(op.va);
-	const auto b = get_vr<s8[16]>(op.vb);
-	const auto d = eval(a - b);
-	const auto x = eval(ucarry(b, d, a) >> 7);
-	set_vr(op.vd, eval(d & ~x));
-	SetSat(IsNotZero(x.value));
+	const auto ab = GetVrs(VrType::vi8, op.va, op.vb);
+	const auto r = Call(GetType<u8[16]>(), m_pure_attr, "llvm.x86.sse2.psubus.b", ab[0], ab[1]);
+	SetVr(op.vd, r);
+	SetSat(IsNotZero(m_ir->CreateXor(r, m_ir->CreateSub(ab[0], ab[1]))));
 }
 
 void PPUTranslator::VSUBUHM(ppu_opcode_t op)
@@ -1515,12 +1710,10 @@ void PPUTranslator::VSUBUHM(ppu_opcode_t op)
 
 void PPUTranslator::VSUBUHS(ppu_opcode_t op)
 {
-	const auto a = get_vr<s16[8]>(op.va);
-	const auto b = get_vr<s16[8]>(op.vb);
-	const auto d = eval(a - b);
-	const auto x = eval(ucarry(b, d, a) >> 15);
-	set_vr(op.vd, eval(d & ~x));
-	SetSat(IsNotZero(x.value));
+	const auto ab = GetVrs(VrType::vi16, op.va, op.vb);
+	const auto r = Call(GetType<u16[8]>(), m_pure_attr, "llvm.x86.sse2.psubus.w", ab[0], ab[1]);
+	SetVr(op.vd, r);
+	SetSat(IsNotZero(m_ir->CreateXor(r, m_ir->CreateSub(ab[0], ab[1]))));
 }
 
 void PPUTranslator::VSUBUWM(ppu_opcode_t op)
@@ -2335,6 +2528,11 @@ void PPUTranslator::MFOCRF(ppu_opcode_t op)
 
 void PPUTranslator::LWARX(ppu_opcode_t op)
 {
+	if (AtomicLoop(op))
+	{
+		return;
+	}
+
 	SetGpr(op.rd, Call(GetType<u32>(), "__lwarx", m_thread, op.ra ? m_ir->CreateAdd(GetGpr(op.ra), GetGpr(op.rb)) : GetGpr(op.rb)));
 }
 
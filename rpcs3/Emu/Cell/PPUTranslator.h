@@ -17,6 +17,9 @@ class PPUTranslator final : public cpu_translator
 	// Attributes for function calls which are "pure" and may be optimized away if their results are unused
 	const llvm::AttributeSet m_pure_attr;
 
+	// Host supports PSHUFB (inline VPERM)
+	const bool m_use_ssse3;
+
 	// LLVM function
 	llvm::Function* m_function;
 
@@ -26,6 +29,9 @@ class PPUTranslator final : public cpu_translator
 	// Current position-independent address
 	u64 m_addr = 0;
 
+	// End of the current block (position-independent)
+	u64 m_end = 0;
+
 	// Relocation info
 	const ppu_segment* m_reloc = nullptr;
 
@@ -47,6 +53,9 @@ class PPUTranslator final : public cpu_translator
 	// Callable functions
 	llvm::GlobalVariable* m_call;
 
+	// Instruction counters (optional)
+	llvm::GlobalVariable* m_hist = nullptr;
+
 	// Main block
 	llvm::BasicBlock* m_body;
 	llvm::BasicBlock* m_entry;
@@ -279,6 +288,9 @@ public:
 	// Branch to next instruction if condition failed, never branch on nullptr
 	void UseCondition(llvm::MDNode* hint, llvm::Value* = nullptr);
 
+	// Try to translate lwarx/stwcx. loop starting at the current address as a single atomic operation
+	bool AtomicLoop(ppu_opcode_t op);
+
 	// Get memory pointer
 	llvm::Value* GetMemory(llvm::Value* addr, llvm::Type* type);
 
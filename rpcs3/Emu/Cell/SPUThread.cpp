@@ -318,6 +318,91 @@ std::string SPUThread::dump() const
 	return ret;
 }
 
+spu_thread_context SPUThread::save_context() const
+{
+	spu_thread_context ctx{};
+	ctx.version = spu_thread_context::current_version;
+	ctx.pc = pc;
+	ctx.npc = npc;
+	ctx.status = status;
+	ctx.run_ctrl = run_ctrl;
+	ctx.srr0 = srr0;
+	std::memcpy(ctx.fpscr, fpscr._u32, sizeof(ctx.fpscr));
+	ctx.ch_tag_upd = ch_tag_upd;
+	ctx.ch_tag_mask = ch_tag_mask;
+	ctx.ch_stall_mask = ch_stall_mask;
+	ctx.ch_event_mask = ch_event_mask;
+	ctx.ch_event_stat = ch_event_stat;
+	ctx.mfc_prxy_mask = mfc_prxy_mask;
+	ctx.ch_dec_value = ch_dec_value;
+	ctx.interrupts_enabled = interrupts_enabled;
+	ctx.ch_dec_start_timestamp = ch_dec_start_timestamp;
+	ctx.snr_config = snr_config;
+	ctx.ch_tag_stat = ch_tag_stat.data.load();
+	ctx.ch_stall_stat = ch_stall_stat.data.load();
+	ctx.ch_atomic_stat = ch_atomic_stat.data.load();
+	ctx.ch_out_mbox = ch_out_mbox.data.load();
+	ctx.ch_out_intr_mbox = ch_out_intr_mbox.data.load();
+	ctx.ch_snr1 = ch_snr1.data.load();
+	ctx.ch_snr2 = ch_snr2.data.load();
+	ctx.ch_in_mbox = ch_in_mbox.values.load();
+	ctx.ch_in_mbox3 = ch_in_mbox.value3;
+	std::memcpy(ctx.gpr, gpr.data(), sizeof(ctx.gpr));
+
+	if (mfc_queue.size())
+	{
+		LOG_WARNING(SPU, "Context saved with %u pending MFC commands (not captured)", mfc_queue.size());
+	}
+
+	return ctx;
+}
+
+bool SPUThread::load_context(const spu_thread_context& ctx)
+{
+	if (ctx.version != spu_thread_context::current_version)
+	{
+		LOG_ERROR(SPU, "Context version mismatch (%u, expected %u)", ctx.version, spu_thread_context::current_version);
+		return false;
+	}
+
+	if (mfc_queue.size())
+	{
+		LOG_ERROR(SPU, "Cannot load context: %u pending MFC commands", mfc_queue.size());
+		return false;
+	}
+
+	pc = ctx.pc;
+	npc = ctx.npc;
+	status = ctx.status;
+	run_ctrl = ctx.run_ctrl;
+	srr0 = ctx.srr0;
+	std::memcpy(fpscr._u32, ctx.fpscr, sizeof(ctx.fpscr));
+	ch_tag_upd = ctx.ch_tag_upd;
+	ch_tag_mask = ctx.ch_tag_mask;
+	ch_stall_mask = ctx.ch_stall_mask;
+	ch_event_mask = ctx.ch_event_mask;
+	ch_event_stat = ctx.ch_event_stat;
+	mfc_prxy_mask = ctx.mfc_prxy_mask;
+	ch_dec_value = ctx.ch_dec_value;
+	interrupts_enabled = ctx.interrupts_enabled != 0;
+	ch_dec_start_timestamp = ctx.ch_dec_start_timestamp;
+	snr_config = ctx.snr_config;
+	ch_tag_stat.data.store(ctx.ch_tag_stat);
+	ch_stall_stat.data.store(ctx.ch_stall_stat);
+	ch_atomic_stat.data.store(ctx.ch_atomic_stat);
+	ch_out_mbox.data.store(ctx.ch_out_mbox);
+	ch_out_intr_mbox.data.store(ctx.ch_out_intr_mbox);
+	ch_snr1.data.store(ctx.ch_snr1);
+	ch_snr2.data.store(ctx.ch_snr2);
+	ch_in_mbox.values.store(ctx.ch_in_mbox);
+	ch_in_mbox.value3 = ctx.ch_in_mbox3;
+	std::memcpy(gpr.data(), ctx.gpr, sizeof(ctx.gpr));
+
+	// Reservation can't survive restore
+	raddr = 0;
+	return true;
+}
+
 void SPUThread::cpu_init()
 {
 	gpr = {};
@@ -677,7 +762,7 @@ void SPUThread::process_mfc_cmd()
 					break;
 				}
 
-				thread_ctrl::wait_for(100);
+				cpu_wait(100);
 			}
 		}
 		else if (s_use_rtm && utils::transaction_enter())
@@ -1089,7 +1174,7 @@ bool SPUThread::get_ch_value(u32 ch, u32& out)
 			else
 			{
 				ctr++;
-				thread_ctrl::wait();
+				cpu_wait();
 			}
 		}
 
@@ -1127,7 +1212,7 @@ bool SPUThread::get_ch_value(u32 ch, u32& out)
 				return false;
 			}
 
-			thread_ctrl::wait();
+			cpu_wait();
 		}
 	}
 
@@ -1208,7 +1293,10 @@ bool SPUThread::get_ch_value(u32 ch, u32& out)
 				return false;
 			}
 
-			thread_ctrl::wait_for(100);
+			if (cpu_wait(100) && waiter.linked && !get_events())
+			{
+				vm::waiter::count_spurious();
+			}
 		}
 
 		out = res;
@@ -1250,7 +1338,7 @@ bool SPUThread::set_ch_value(u32 ch, u32 value)
 					return false;
 				}
 
-				thread_ctrl::wait();
+				cpu_wait();
 			}
 
 			int_ctrl[2].set(SPU_INT2_STAT_MAILBOX_INT);
@@ -1396,7 +1484,7 @@ bool SPUThread::set_ch_value(u32 ch, u32 value)
 				return false;
 			}
 
-			thread_ctrl::wait();
+			cpu_wait();
 		}
 
 		return true;
@@ -1605,7 +1693,7 @@ bool SPUThread::stop_and_signal(u32 code)
 				return false;
 			}
 
-			thread_ctrl::wait_for(1000);
+			cpu_wait(1000);
 		}
 
 		return false;
@@ -1661,7 +1749,7 @@ bool SPUThread::stop_and_signal(u32 code)
 					return false;
 				}
 
-				thread_ctrl::wait();
+				cpu_wait();
 			}
 
 			reader_lock rlock(id_manager::g_mutex);
@@ -1694,9 +1782,10 @@ bool SPUThread::stop_and_signal(u32 code)
 
 			semaphore_lock qlock(queue->mutex);
 
-			if (queue->events.empty())
+			lv2_event event;
+
+			if (!queue->receive(*this, event))
 			{
-				queue->sq.emplace_back(this);
 				group->run_state = SPU_THREAD_GROUP_STATUS_WAITING;
 
 				for (auto& thread : group->threads)
@@ -1713,12 +1802,10 @@ bool SPUThread::stop_and_signal(u32 code)
 			else
 			{
 				// Return the event immediately
-				const auto event = queue->events.front();
 				const auto data1 = static_cast<u32>(std::get<1>(event));
 				const auto data2 = static_cast<u32>(std::get<2>(event));
 				const auto data3 = static_cast<u32>(std::get<3>(event));
 				ch_in_mbox.set_values(4, CELL_OK, data1, data2, data3);
-				queue->events.pop_front();
 				return true;
 			}
 		}
@@ -1732,7 +1819,7 @@ bool SPUThread::stop_and_signal(u32 code)
 
 			if (!state.test_and_reset(cpu_flag::signal))
 			{
-				thread_ctrl::wait();
+				cpu_wait();
 			}
 			else
 			{
@@ -501,6 +501,40 @@ public:
 	}
 };
 
+// SPU register and channel state (trivially copyable, LS contents are part of vm block dumps)
+struct spu_thread_context
+{
+	static const u32 current_version = 1;
+
+	u32 version;
+	u32 pc;
+	u32 npc;
+	u32 status;
+	u32 run_ctrl;
+	u32 srr0;
+	u32 fpscr[4];
+	u32 ch_tag_upd;
+	u32 ch_tag_mask;
+	u32 ch_stall_mask;
+	u32 ch_event_mask;
+	u32 ch_event_stat;
+	u32 mfc_prxy_mask;
+	u32 ch_dec_value;
+	u32 interrupts_enabled;
+	u64 ch_dec_start_timestamp;
+	u64 snr_config;
+	spu_channel_t::sync_var_t ch_tag_stat;
+	spu_channel_t::sync_var_t ch_stall_stat;
+	spu_channel_t::sync_var_t ch_atomic_stat;
+	spu_channel_t::sync_var_t ch_out_mbox;
+	spu_channel_t::sync_var_t ch_out_intr_mbox;
+	spu_channel_t::sync_var_t ch_snr1;
+	spu_channel_t::sync_var_t ch_snr2;
+	spu_channel_4_t::sync_var_t ch_in_mbox;
+	u32 ch_in_mbox3;
+	v128 gpr[128];
+};
+
 class SPUThread : public cpu_thread
 {
 public:
@@ -590,6 +624,12 @@ public:
 	std::shared_ptr<class spu_recompiler_base> spu_rec;
 	u32 recursion_level = 0;
 
+	// Save register state (thread must be paused with snapshot_pause() or be the current thread)
+	spu_thread_context save_context() const;
+
+	// Restore register state, returns false on version mismatch or pending MFC commands
+	bool load_context(const spu_thread_context&);
+
 	void push_snr(u32 number, u32 value);
 	void do_dma_transfer(const spu_mfc_cmd& args, bool from_mfc = true);
 
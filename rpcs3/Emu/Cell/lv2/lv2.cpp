@@ -1007,17 +1007,181 @@ extern ppu_function_t ppu_get_syscall(u64 code)
 
 extern u64 get_system_time();
 
+// Bitmap-indexed run queue for PPU threads (intrusive: links are stored in ppu_thread, no allocations)
+struct ppu_run_queue
+{
+	static const u32 levels = 3072;
+
+	// Non-empty priority levels
+	std::array<u64, levels / 64> bits{};
+
+	// Non-empty words of bits
+	u64 summary = 0;
+
+	// FIFO queue per priority level (first and last thread)
+	std::array<ppu_thread*, levels> heads{};
+	std::array<ppu_thread*, levels> tails{};
+
+	// Find first non-empty level starting from the specified one (or -1)
+	u32 find(u32 level) const
+	{
+		if (level >= levels)
+		{
+			return -1;
+		}
+
+		u32 word = level / 64;
+
+		if (const u64 found = bits[word] & (~0ull << (level % 64)))
+		{
+			return word * 64 + static_cast<u32>(cnttz64(found, true));
+		}
+
+		const u64 rest = word + 1 < 64 ? summary & (~0ull << (word + 1)) : 0;
+
+		if (!rest)
+		{
+			return -1;
+		}
+
+		word = static_cast<u32>(cnttz64(rest, true));
+		return word * 64 + static_cast<u32>(cnttz64(bits[word], true));
+	}
+
+	bool contains(ppu_thread* thread) const
+	{
+		return thread->sched_level != -1;
+	}
+
+	void push(ppu_thread* thread, u32 prio)
+	{
+		const u32 level = std::min(prio, levels - 1);
+
+		thread->sched_level = level;
+		thread->sched_prev = tails[level];
+		thread->sched_next = nullptr;
+
+		if (tails[level])
+		{
+			tails[level]->sched_next = thread;
+		}
+		else
+		{
+			heads[level] = thread;
+			bits[level / 64] |= 1ull << (level % 64);
+			summary |= 1ull << (level / 64);
+		}
+
+		tails[level] = thread;
+	}
+
+	bool remove(ppu_thread* thread)
+	{
+		const u32 level = thread->sched_level;
+
+		if (level == -1)
+		{
+			return false;
+		}
+
+		(thread->sched_prev ? thread->sched_prev->sched_next : heads[level]) = thread->sched_next;
+		(thread->sched_next ? thread->sched_next->sched_prev : tails[level]) = thread->sched_prev;
+
+		thread->sched_prev = nullptr;
+		thread->sched_next = nullptr;
+		thread->sched_level = -1;
+
+		if (!heads[level])
+		{
+			if (!(bits[level / 64] &= ~(1ull << (level % 64))))
+			{
+				summary &= ~(1ull << (level / 64));
+			}
+		}
+
+		return true;
+	}
+
+	// Check whether the thread is followed by a thread of different priority (yield is pointless)
+	bool is_last_of_prio(ppu_thread* thread) const
+	{
+		if (thread->sched_level == -1 || thread->sched_next)
+		{
+			return false;
+		}
+
+		return find(thread->sched_level + 1) != -1;
+	}
+
+	// Visit threads in scheduling order while func returns true
+	template <typename F>
+	void for_each(F&& func) const
+	{
+		for (u32 level = find(0); level != -1; level = find(level + 1))
+		{
+			for (ppu_thread* thread = heads[level]; thread; thread = thread->sched_next)
+			{
+				if (!func(thread))
+				{
+					return;
+				}
+			}
+		}
+	}
+
+	void clear()
+	{
+		for (u32 level = find(0); level != -1; level = find(level + 1))
+		{
+			for (ppu_thread* thread = heads[level]; thread;)
+			{
+				ppu_thread* const next = thread->sched_next;
+				thread->sched_prev = nullptr;
+				thread->sched_next = nullptr;
+				thread->sched_level = -1;
+				thread = next;
+			}
+
+			heads[level] = nullptr;
+			tails[level] = nullptr;
+		}
+
+		bits = {};
+		summary = 0;
+	}
+};
+
 DECLARE(lv2_obj::g_mutex);
 DECLARE(lv2_obj::g_ppu);
 DECLARE(lv2_obj::g_pending);
-DECLARE(lv2_obj::g_waiting);
+
+// Scheduling decision latency (including the scheduler lock wait)
+static atomic_t<u64> s_sched_count{0};
+static atomic_t<u64> s_sched_time{0};
+static atomic_t<u64> s_sched_max{0};
+
+struct sched_latency_counter
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	~sched_latency_counter()
+	{
+		const u64 time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+		s_sched_count++;
+		s_sched_time += time;
+		s_sched_max.atomic_op([&](u64& max) { max = std::max(max, time); });
+	}
+};
 
 void lv2_obj::sleep_timeout(named_thread& thread, u64 timeout)
 {
-	semaphore_lock lock(g_mutex);
+	sched_latency_counter counter;
 
 	const u64 start_time = get_system_time();
 
+	semaphore_lock lock(g_mutex);
+
 	if (auto ppu = dynamic_cast<ppu_thread*>(&thread))
 	{
 		LOG_TRACE(PPU, "sleep() - waiting (%zu)", g_pending.size());
@@ -1037,7 +1201,7 @@ void lv2_obj::sleep_timeout(named_thread& thread, u64 timeout)
 		}
 
 		// Find and remove the thread
-		unqueue(g_ppu, ppu);
+		g_ppu.remove(ppu);
 		unqueue(g_pending, ppu);
 
 		ppu->start_time = start_time;
@@ -1045,19 +1209,8 @@ void lv2_obj::sleep_timeout(named_thread& thread, u64 timeout)
 
 	if (timeout)
 	{
-		const u64 wait_until = start_time + timeout;
-
 		// Register timeout if necessary
-		for (auto it = g_waiting.begin(), end = g_waiting.end(); it != end; it++)
-		{
-			if (it->first > wait_until)
-			{
-				g_waiting.emplace(it, wait_until, &thread);
-				return;
-			}
-		}
-
-		g_waiting.emplace_back(wait_until, &thread);
+		lv2_timeout_arm(thread, start_time + timeout);
 	}
 
 	schedule_all();
@@ -1068,65 +1221,51 @@ void lv2_obj::awake(cpu_thread& cpu, u32 prio)
 	// Check thread type
 	if (cpu.id_type() != 1) return;
 
+	sched_latency_counter counter;
+
+	auto& ppu = static_cast<ppu_thread&>(cpu);
+
+	const u64 start_time = prio == -4 ? get_system_time() : 0;
+
 	semaphore_lock lock(g_mutex);
 
 	if (prio == -4)
 	{
 		// Yield command
-		const u64 start_time = get_system_time();
+		if (g_ppu.is_last_of_prio(&ppu))
+		{
+			return;
+		}
 
-		for (std::size_t i = 0, pos = -1; i < g_ppu.size(); i++)
+		if (g_ppu.remove(&ppu))
 		{
-			if (g_ppu[i] == &cpu)
-			{
-				pos = i;
-				prio = g_ppu[i]->prio;
-			}
-			else if (i == pos + 1 && prio != -4 && g_ppu[i]->prio != prio)
-			{
-				return;
-			}
+			unqueue(g_pending, &cpu);
+			ppu.start_time = start_time;
+			return;
 		}
 
-		unqueue(g_ppu, &cpu);
 		unqueue(g_pending, &cpu);
-
-		static_cast<ppu_thread&>(cpu).start_time = start_time;
+		ppu.start_time = start_time;
 	}
-
-	if (prio < INT32_MAX && !unqueue(g_ppu, &cpu))
+	else if (prio < INT32_MAX && !g_ppu.remove(&ppu))
 	{
 		// Priority set
 		return;
 	}
 
 	// Emplace current thread
-	for (std::size_t i = 0; i <= g_ppu.size(); i++)
+	if (g_ppu.contains(&ppu))
+	{
+		LOG_TRACE(PPU, "sleep() - suspended (p=%zu)", g_pending.size());
+	}
+	else
 	{
-		if (i < g_ppu.size() && g_ppu[i] == &cpu)
-		{
-			LOG_TRACE(PPU, "sleep() - suspended (p=%zu)", g_pending.size());
-			break;
-		}
-
 		// Use priority, also preserve FIFO order
-		if (i == g_ppu.size() || g_ppu[i]->prio > static_cast<ppu_thread&>(cpu).prio)
-		{
-			LOG_TRACE(PPU, "awake(): %s", cpu.id);
-			g_ppu.insert(g_ppu.cbegin() + i, &static_cast<ppu_thread&>(cpu));
+		LOG_TRACE(PPU, "awake(): %s", cpu.id);
+		g_ppu.push(&ppu, ppu.prio);
 
-			// Unregister timeout if necessary
-			for (auto it = g_waiting.cbegin(), end = g_waiting.cend(); it != end; it++)
-			{
-				if (it->second == &cpu)
-				{
-					g_waiting.erase(it);
-					break;
-				}
-			}
-
-			break;
-		}
+		// Unregister timeout if necessary
+		lv2_timeout_cancel(cpu);
 	}
 
 	// Remove pending if necessary
@@ -1135,12 +1274,30 @@ void lv2_obj::awake(cpu_thread& cpu, u32 prio)
 		unqueue(g_pending, &cpu);
 	}
 
-	// Suspend threads if necessary
-	for (std::size_t i = g_cfg.core.ppu_threads; i < g_ppu.size(); i++)
+	// Suspend threads if necessary: threads beyond the first ppu_threads were suspended before,
+	// so only the thread displaced by this one and this thread itself need to be checked
+	const u32 max = g_cfg.core.ppu_threads;
+	ppu_thread* displaced = nullptr;
+	bool running = false;
+	u32 pos = 0;
+
+	g_ppu.for_each([&](ppu_thread* thread)
 	{
-		const auto target = g_ppu[i];
+		if (pos < max)
+		{
+			running |= thread == &ppu;
+		}
+		else
+		{
+			displaced = thread;
+		}
+
+		return pos++ < max;
+	});
 
-		if (!target->state.test_and_set(cpu_flag::suspend))
+	for (ppu_thread* target : {displaced, running || !g_ppu.contains(&ppu) ? static_cast<ppu_thread*>(nullptr) : &ppu})
+	{
+		if (target && !target->state.test_and_set(cpu_flag::suspend))
 		{
 			LOG_TRACE(PPU, "suspend(): %s", target->id);
 			g_pending.emplace_back(target);
@@ -1154,7 +1311,12 @@ void lv2_obj::cleanup()
 {
 	g_ppu.clear();
 	g_pending.clear();
-	g_waiting.clear();
+	lv2_timeout_cleanup();
+
+	if (const u64 count = s_sched_count.exchange(0))
+	{
+		LOG_NOTICE(PPU, "Scheduler: %u decisions, average latency %u ns, max %u ns", count, s_sched_time.exchange(0) / count, s_sched_max.exchange(0));
+	}
 }
 
 void lv2_obj::schedule_all()
@@ -1162,9 +1324,14 @@ void lv2_obj::schedule_all()
 	if (g_pending.empty())
 	{
 		// Wake up threads
-		for (std::size_t i = 0, x = std::min<std::size_t>(g_cfg.core.ppu_threads, g_ppu.size()); i < x; i++)
+		u32 count = 0;
+
+		g_ppu.for_each([&](ppu_thread* target)
 		{
-			const auto target = g_ppu[i];
+			if (count++ >= g_cfg.core.ppu_threads)
+			{
+				return false;
+			}
 
 			if (test(target->state, cpu_flag::suspend))
 			{
@@ -1177,24 +1344,9 @@ void lv2_obj::schedule_all()
 					target->notify();
 				}
 			}
-		}
-	}
 
-	// Check registered timeouts
-	while (!g_waiting.empty())
-	{
-		auto& pair = g_waiting.front();
-
-		if (pair.first <= get_system_time())
-		{
-			pair.second->notify();
-			g_waiting.pop_front();
-		}
-		else
-		{
-			// The list is sorted so assume no more timeouts
-			break;
-		}
+			return true;
+		});
 	}
 }
 
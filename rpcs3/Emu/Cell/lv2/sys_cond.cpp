@@ -267,11 +267,11 @@ error_code sys_cond_wait(ppu_thread& ppu, u32 cond_id, u64 timeout)
 				continue;
 			}
 
-			thread_ctrl::wait_for(timeout - passed);
+			ppu.cpu_wait(timeout - passed);
 		}
 		else
 		{
-			thread_ctrl::wait();
+			ppu.cpu_wait();
 		}
 	}
 
@@ -29,28 +29,92 @@ std::shared_ptr<lv2_event_queue> lv2_event_queue::find(u64 ipc_key)
 	return ipc_manager<lv2_event_queue, u64>::get(ipc_key);
 }
 
-bool lv2_event_queue::send(lv2_event event)
+bool lv2_event_queue::push(const lv2_event& event)
 {
-	semaphore_lock lock(mutex);
-
-	if (sq.empty())
+	// Reserve space (the ring can't overflow because size < ring_size)
+	if (count.fetch_op([&](s32& value)
 	{
-		if (events.size() < this->size)
+		if (value < size)
 		{
-			// Save event
-			events.emplace_back(event);
-			return true;
+			value++;
 		}
+	}) >= size)
+	{
+		return false;
+	}
+
+	const u32 pos = ring_tail++;
+
+	auto& cell = ring[pos % ring_size];
+	cell.data = event;
+	cell.seq = pos + 1;
+	return true;
+}
+
+bool lv2_event_queue::pop(lv2_event& event)
+{
+	const u32 pos = ring_head;
+
+	auto& cell = ring[pos % ring_size];
 
+	if (cell.seq != pos + 1)
+	{
+		// Empty or the sender hasn't finished yet (it will flush the event itself)
 		return false;
 	}
 
+	event = cell.data;
+	cell.seq = pos + ring_size;
+	ring_head = pos + 1;
+	count--;
+	return true;
+}
+
+bool lv2_event_queue::receive(cpu_thread& cpu, lv2_event& event)
+{
+	if (pop(event))
+	{
+		return true;
+	}
+
+	sq.emplace_back(&cpu);
+	waiters++;
+
+	// Recheck: senders check waiters after publishing the event
+	if (pop(event))
+	{
+		sq.pop_back();
+		waiters--;
+		return true;
+	}
+
+	return false;
+}
+
+bool lv2_event_queue::unqueue_waiter(cpu_thread& cpu)
+{
+	if (unqueue(sq, &cpu))
+	{
+		waiters--;
+		return true;
+	}
+
+	return false;
+}
+
+void lv2_event_queue::deliver(const lv2_event& event)
+{
+	waiters--;
+
 	if (type == SYS_PPU_QUEUE)
 	{
 		// Store event in registers
 		auto& ppu = static_cast<ppu_thread&>(*schedule<ppu_thread>(sq, protocol));
 
-		std::tie(ppu.gpr[4], ppu.gpr[5], ppu.gpr[6], ppu.gpr[7]) = event;
+		{
+			cpu_reg_lock reg_lock(ppu);
+			std::tie(ppu.gpr[4], ppu.gpr[5], ppu.gpr[6], ppu.gpr[7]) = event;
+		}
 
 		awake(ppu);
 	}
@@ -70,7 +134,52 @@ bool lv2_event_queue::send(lv2_event event)
 		spu.state += cpu_flag::signal;
 		spu.notify();
 	}
+}
+
+void lv2_event_queue::flush()
+{
+	lv2_event event;
+
+	while (!sq.empty() && pop(event))
+	{
+		deliver(event);
+	}
+}
+
+bool lv2_event_queue::send(lv2_event event)
+{
+	if (!waiters)
+	{
+		// Fast path: nobody is waiting
+		if (push(event))
+		{
+			if (waiters)
+			{
+				// A receiver started waiting concurrently
+				semaphore_lock lock(mutex);
+				flush();
+			}
 
+			return true;
+		}
+
+		if (!waiters)
+		{
+			return false;
+		}
+	}
+
+	semaphore_lock lock(mutex);
+
+	// Preserve order of the events stored before
+	flush();
+
+	if (sq.empty())
+	{
+		return push(event);
+	}
+
+	deliver(event);
 	return true;
 }
 
@@ -175,7 +284,11 @@ error_code sys_event_queue_destroy(ppu_thread& ppu, u32 equeue_id, s32 mode)
 		{
 			if (queue->type == SYS_PPU_QUEUE)
 			{
-				static_cast<ppu_thread&>(*cpu).gpr[3] = CELL_ECANCELED;
+				{
+					cpu_reg_lock reg_lock(*cpu);
+					static_cast<ppu_thread&>(*cpu).gpr[3] = CELL_ECANCELED;
+				}
+
 				queue->awake(*cpu);
 			}
 			else
@@ -210,11 +323,11 @@ error_code sys_event_queue_tryreceive(u32 equeue_id, vm::ptr<sys_event_t> event_
 
 	s32 count = 0;
 
-	while (queue->sq.empty() && count < size && !queue->events.empty())
+	lv2_event event;
+
+	while (queue->sq.empty() && count < size && queue->pop(event))
 	{
 		auto& dest = event_array[count++];
-		auto event = queue->events.front();
-		queue->events.pop_front();
 
 		std::tie(dest.source, dest.data1, dest.data2, dest.data3) = event;
 	}
@@ -238,16 +351,16 @@ error_code sys_event_queue_receive(ppu_thread& ppu, u32 equeue_id, vm::ptr<sys_e
 		}
 
 		semaphore_lock lock(queue.mutex);
-		
-		if (queue.events.empty())
+
+		lv2_event event;
+
+		if (!queue.receive(ppu, event))
 		{
-			queue.sq.emplace_back(&ppu);
 			queue.sleep(ppu, timeout);
 			return CELL_EBUSY;
 		}
 
-		std::tie(ppu.gpr[4], ppu.gpr[5], ppu.gpr[6], ppu.gpr[7]) = queue.events.front();
-		queue.events.pop_front();
+		std::tie(ppu.gpr[4], ppu.gpr[5], ppu.gpr[6], ppu.gpr[7]) = event;
 		return {};
 	});
 
@@ -279,7 +392,7 @@ error_code sys_event_queue_receive(ppu_thread& ppu, u32 equeue_id, vm::ptr<sys_e
 			{
 				semaphore_lock lock(queue->mutex);
 
-				if (!queue->unqueue(queue->sq, &ppu))
+				if (!queue->unqueue_waiter(ppu))
 				{
 					timeout = 0;
 					continue;
@@ -289,11 +402,11 @@ error_code sys_event_queue_receive(ppu_thread& ppu, u32 equeue_id, vm::ptr<sys_e
 				break;
 			}
 
-			thread_ctrl::wait_for(timeout - passed);
+			ppu.cpu_wait(timeout - passed);
 		}
 		else
 		{
-			thread_ctrl::wait();
+			ppu.cpu_wait();
 		}
 	}
 
@@ -308,7 +421,11 @@ error_code sys_event_queue_drain(u32 equeue_id)
 	{
 		semaphore_lock lock(queue.mutex);
 
-		queue.events.clear();
+		lv2_event event;
+
+		while (queue.pop(event))
+		{
+		}
 	});
 
 	if (!queue)
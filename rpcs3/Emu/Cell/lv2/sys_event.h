@@ -84,9 +84,23 @@ struct lv2_event_queue final : public lv2_obj
 	const s32 size;
 
 	semaphore<> mutex;
-	std::deque<lv2_event> events;
 	std::deque<cpu_thread*> sq;
 
+	// Bounded event ring: senders don't take the mutex while there are no waiters, receivers do
+	static const u32 ring_size = 128; // Power of 2, greater than max queue size
+
+	struct event_cell
+	{
+		atomic_t<u32> seq; // Equal to position if free, position + 1 if published
+		lv2_event data;
+	};
+
+	std::array<event_cell, ring_size> ring;
+	atomic_t<u32> ring_head{0}; // Next position to read (mutex must be locked)
+	atomic_t<u32> ring_tail{0}; // Next position to write
+	atomic_t<s32> count{0}; // Events stored or being stored
+	atomic_t<u32> waiters{0}; // Size of sq, checked by senders after storing an event
+
 	lv2_event_queue(u32 protocol, s32 type, u64 name, u64 ipc_key, s32 size)
 		: protocol(protocol)
 		, type(type)
@@ -94,15 +108,40 @@ struct lv2_event_queue final : public lv2_obj
 		, key(ipc_key)
 		, size(size)
 	{
+		for (u32 i = 0; i < ring_size; i++)
+		{
+			ring[i].seq.raw() = i;
+		}
 	}
 
 	bool send(lv2_event);
 
+	// Take the oldest published event (mutex must be locked)
+	bool pop(lv2_event&);
+
+	// Take an event or register the waiter in sq (mutex must be locked)
+	bool receive(cpu_thread&, lv2_event&);
+
+	// Remove the waiter from sq (mutex must be locked)
+	bool unqueue_waiter(cpu_thread&);
+
 	bool send(u64 source, u64 d1, u64 d2, u64 d3)
 	{
 		return send(std::make_tuple(source, d1, d2, d3));
 	}
 
+private:
+	// Store event in the ring without locking
+	bool push(const lv2_event&);
+
+	// Hand over the event to the first waiter (mutex must be locked)
+	void deliver(const lv2_event&);
+
+	// Hand over stored events to the waiters (mutex must be locked)
+	void flush();
+
+public:
+
 	// Get event queue by its global key
 	static std::shared_ptr<lv2_event_queue> find(u64 ipc_key);
 };
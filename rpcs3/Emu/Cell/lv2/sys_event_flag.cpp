@@ -179,11 +179,11 @@ error_code sys_event_flag_wait(ppu_thread& ppu, u32 id, u64 bitptn, u32 mode, vm
 				break;
 			}
 
-			thread_ctrl::wait_for(timeout - passed);
+			ppu.cpu_wait(timeout - passed);
 		}
 		else
 		{
-			thread_ctrl::wait();
+			ppu.cpu_wait();
 		}
 	}
 	
@@ -265,6 +265,8 @@ error_code sys_event_flag_set(u32 id, u64 bitptn)
 			{
 				auto& ppu = static_cast<ppu_thread&>(*cpu);
 
+				cpu_reg_lock reg_lock(ppu);
+
 				const u64 pattern = ppu.gpr[4];
 				const u64 mode = ppu.gpr[5];
 				
@@ -349,8 +351,11 @@ error_code sys_event_flag_cancel(ppu_thread& ppu, u32 id, vm::ptr<u32> num)
 		{
 			auto& ppu = static_cast<ppu_thread&>(*thread);
 
-			ppu.gpr[3] = CELL_ECANCELED;
-			ppu.gpr[6] = pattern;
+			{
+				cpu_reg_lock reg_lock(ppu);
+				ppu.gpr[3] = CELL_ECANCELED;
+				ppu.gpr[6] = pattern;
+			}
 
 			flag->waiters--;
 			flag->awake(ppu);
@@ -2,7 +2,9 @@
 #include "sys_fs.h"
 
 #include <mutex>
+#include <deque>
 
+#include "Emu/System.h"
 #include "Emu/Cell/PPUThread.h"
 #include "Crypto/unedat.h"
 #include "Emu/VFS.h"
@@ -66,6 +68,12 @@ lv2_fs_mount_point* lv2_fs_object::get_mp(const char* filename)
 
 u64 lv2_file::op_read(vm::ps3::ptr<void> buf, u64 size)
 {
+	if (mapped)
+	{
+		// Copy directly from the mapping
+		return file.read(buf.get_ptr(), size);
+	}
+
 	// Copy data from intermediate buffer (avoid passing vm pointer to a native API)
 	std::unique_ptr<u8[]> local_buf(new u8[size]);
 	const u64 result = file.read(local_buf.get(), size);
@@ -81,6 +89,221 @@ u64 lv2_file::op_write(vm::ps3::cptr<void> buf, u64 size)
 	return file.write(local_buf.get(), size);
 }
 
+bool lv2_file::is_positional() const
+{
+#ifdef _WIN32
+	// Positional ReadFile/WriteFile still move the file pointer
+	return false;
+#else
+	return file.get_handle() != -1;
+#endif
+}
+
+u64 lv2_file::op_read_at(u64 offset, vm::ps3::ptr<void> buf, u64 size)
+{
+	if (mapped)
+	{
+		return file.read_at(offset, buf.get_ptr(), size);
+	}
+
+	std::unique_ptr<u8[]> local_buf(new u8[size]);
+	const u64 result = file.read_at(offset, local_buf.get(), size);
+	std::memcpy(buf.get_ptr(), local_buf.get(), result);
+	return result;
+}
+
+u64 lv2_file::op_write_at(u64 offset, vm::ps3::cptr<void> buf, u64 size)
+{
+	std::unique_ptr<u8[]> local_buf(new u8[size]);
+	std::memcpy(local_buf.get(), buf.get_ptr(), size);
+	return file.write_at(offset, local_buf.get(), size);
+}
+
+// Asynchronous read-ahead for sequentially read files
+struct lv2_fs_prefetcher
+{
+	static const u32 max_files = 16; // Buffer pool size (in buffer pairs)
+	static const u64 min_chunk = 0x40000;
+	static const u64 max_chunk = 0x100000; // Also buffer size
+
+	std::mutex mutex;
+	std::deque<std::shared_ptr<lv2_file>> queue;
+	std::shared_ptr<thread_ctrl> thread;
+	bool running = false;
+
+	atomic_t<u32> files{0};
+
+	// Check whether the file is worth reading ahead (buffered data isn't invalidated by writes: only disc files are read ahead)
+	static bool is_eligible(const lv2_file& file)
+	{
+		return !file.mapped && std::strncmp(file.name.data(), "/dev_bdvd/", 10) == 0 && (file.flags & CELL_FS_O_ACCMODE) == CELL_FS_O_RDONLY && file.is_positional();
+	}
+
+	// Read using the buffer, detect sequential access and schedule read-ahead (mount point must be locked)
+	u64 read(const std::shared_ptr<lv2_file>& file, vm::ptr<void> buf, u64 size);
+
+	void task();
+};
+
+static lv2_fs_prefetcher s_prefetcher;
+
+lv2_file_prefetch::~lv2_file_prefetch()
+{
+	if (buf)
+	{
+		s_prefetcher.files--;
+	}
+}
+
+u64 lv2_fs_prefetcher::read(const std::shared_ptr<lv2_file>& file, vm::ptr<void> buf, u64 size)
+{
+	auto& state = file->prefetch;
+
+	const u64 pos = file->file.pos();
+
+	u64 result = 0;
+	bool request = false;
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+
+		if (pos >= state.pos && pos < state.pos + state.size)
+		{
+			// Copy buffered data
+			result = std::min<u64>(size, state.pos + state.size - pos);
+			std::memcpy(buf.get_ptr(), state.buf.get() + (pos - state.pos), result);
+			state.hits++;
+		}
+		else if (state.streak >= 2)
+		{
+			state.misses++;
+		}
+	}
+
+	if (result)
+	{
+		file->file.seek(pos + result);
+	}
+
+	if (result < size)
+	{
+		result += file->op_read(vm::ptr<void>::make(buf.addr() + static_cast<u32>(result)), size - result);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+
+		state.streak = state.next == pos ? state.streak + 1 : 0;
+		state.next = pos + result;
+
+		const u64 end = std::max<u64>(state.pos + state.size, state.next);
+
+		// Read ahead if the buffered data will run out soon
+		if (state.streak >= 2 && result == size && size <= max_chunk / 2 && !state.busy && end < state.next + size * 2)
+		{
+			if (state.buf || files.fetch_op([](u32& value)
+			{
+				if (value < max_files)
+				{
+					value++;
+				}
+			}) < max_files)
+			{
+				if (!state.buf)
+				{
+					state.buf.reset(new u8[max_chunk]);
+					state.spare.reset(new u8[max_chunk]);
+				}
+
+				state.busy = true;
+				state.req_pos = end;
+				state.req_size = std::min<u64>(std::max<u64>(size * 4, min_chunk), max_chunk);
+				request = true;
+			}
+		}
+	}
+
+	if (request)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		queue.emplace_back(file);
+
+		if (!running)
+		{
+			running = true;
+
+			thread_ctrl::spawn(thread, "FS Prefetch Thread", []
+			{
+				s_prefetcher.task();
+			});
+		}
+		else
+		{
+			thread->notify();
+		}
+	}
+
+	return result;
+}
+
+void lv2_fs_prefetcher::task()
+{
+	while (!Emu.IsStopped())
+	{
+		std::shared_ptr<lv2_file> file;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (!queue.empty())
+			{
+				file = std::move(queue.front());
+				queue.pop_front();
+			}
+		}
+
+		if (!file)
+		{
+			// Notified by read() or on emulation stop
+			thread_ctrl::wait();
+			continue;
+		}
+
+		auto& state = file->prefetch;
+
+		u8* data;
+		u64 pos, size;
+		{
+			std::lock_guard<std::mutex> lock(state.mutex);
+			data = state.spare.get();
+			pos = state.req_pos;
+			size = state.req_size;
+		}
+
+		// Positional read doesn't interfere with the synchronous reads
+		size = file->file.read_at(pos, data, size);
+
+		std::lock_guard<std::mutex> lock(state.mutex);
+		std::swap(state.buf, state.spare);
+		state.pos = pos;
+		state.size = size;
+		state.busy = false;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	queue.clear();
+	running = false;
+}
+
+void lv2_fs_prefetch_stop()
+{
+	std::lock_guard<std::mutex> lock(s_prefetcher.mutex);
+
+	if (s_prefetcher.running)
+	{
+		s_prefetcher.thread->notify();
+	}
+}
+
 struct lv2_file::file_view : fs::file_base
 {
 	const std::shared_ptr<lv2_file> m_file;
@@ -110,11 +333,7 @@ struct lv2_file::file_view : fs::file_base
 
 	u64 read(void* buffer, u64 size) override
 	{
-		const u64 old_pos = m_file->file.pos();
-		const u64 new_pos = m_file->file.seek(m_off + m_pos);
-		const u64 result = m_file->file.read(buffer, size);
-		verify(HERE), old_pos == m_file->file.seek(old_pos);
-
+		const u64 result = read_at(m_pos, buffer, size);
 		m_pos += result;
 		return result;
 	}
@@ -124,6 +343,16 @@ struct lv2_file::file_view : fs::file_base
 		return 0;
 	}
 
+	u64 read_at(u64 offset, void* buffer, u64 size) override
+	{
+		return m_file->file.read_at(m_off + offset, buffer, size);
+	}
+
+	u64 write_at(u64 offset, const void* buffer, u64 size) override
+	{
+		return 0;
+	}
+
 	u64 seek(s64 offset, fs::seek_mode whence) override
 	{
 		const s64 new_pos =
@@ -197,7 +426,7 @@ error_code sys_fs_open(vm::cptr<char> path, s32 flags, vm::ptr<u32> fd, s32 mode
 		return CELL_EINVAL;
 	}
 
-	const std::string& local_path = vfs::get(path.get_ptr());
+	std::string local_path = vfs::get(path.get_ptr());
 
 	if (local_path.empty())
 	{
@@ -274,6 +503,27 @@ error_code sys_fs_open(vm::cptr<char> path, s32 flags, vm::ptr<u32> fd, s32 mode
 
 	fs::file file(local_path, open_mode);
 
+	if (test(open_mode & fs::create))
+	{
+		// Invalidate after the host change (a concurrent lookup could cache the old state otherwise)
+		vfs::invalidate(path.get_ptr());
+	}
+
+	if (!file && !test(open_mode & fs::create) && fs::g_tls_error == fs::error::noent)
+	{
+		fs::stat_t info;
+
+		// Retry with case-corrected path
+		if (vfs::stat(path.get_ptr(), local_path, info) && !info.is_directory)
+		{
+			file.open(local_path, open_mode);
+		}
+		else
+		{
+			fs::g_tls_error = fs::error::noent;
+		}
+	}
+
 	if (!file)
 	{
 		if (test(open_mode & fs::excl) && fs::g_tls_error == fs::error::exist)
@@ -338,7 +588,15 @@ error_code sys_fs_open(vm::cptr<char> path, s32 flags, vm::ptr<u32> fd, s32 mode
 		}
 	}
 
-	if (const u32 id = idm::make<lv2_fs_object, lv2_file>(path.get_ptr(), std::move(file), mode, flags))
+	bool mapped = false;
+
+	// Map large disc files (nothing else can modify them, unlike files of /dev_hdd0 written by HLE modules)
+	if (!test(open_mode - fs::read) && !(flags & CELL_FS_O_MSELF) && file.size() >= 0x400000 && std::strncmp(path.get_ptr(), "/dev_bdvd/", 10) == 0)
+	{
+		mapped = file.map_readonly();
+	}
+
+	if (const u32 id = idm::make<lv2_fs_object, lv2_file>(path.get_ptr(), std::move(file), mode, flags, mapped))
 	{
 		*fd = id;
 		return CELL_OK;
@@ -366,7 +624,7 @@ error_code sys_fs_read(u32 fd, vm::ptr<void> buf, u64 nbytes, vm::ptr<u64> nread
 
 	std::lock_guard<std::mutex> lock(file->mp->mutex);
 
-	*nread = file->op_read(buf, nbytes);
+	*nread = lv2_fs_prefetcher::is_eligible(*file) ? s_prefetcher.read(file, buf, nbytes) : file->op_read(buf, nbytes);
 
 	return CELL_OK;
 }
@@ -418,6 +676,11 @@ error_code sys_fs_close(u32 fd)
 		return file.ret;
 	}
 
+	if (const u64 total = file->prefetch.hits + file->prefetch.misses)
+	{
+		sys_fs.notice("sys_fs_close(): read-ahead hit rate %u%% (%u/%u) for %s", file->prefetch.hits * 100 / total, file->prefetch.hits, total, file->name.data());
+	}
+
 	return CELL_OK;
 }
 
@@ -425,7 +688,7 @@ error_code sys_fs_opendir(vm::cptr<char> path, vm::ptr<u32> fd)
 {
 	sys_fs.warning("sys_fs_opendir(path=%s, fd=*0x%x)", path, fd);
 
-	const std::string& local_path = vfs::get(path.get_ptr());
+	std::string local_path = vfs::get(path.get_ptr());
 
 	if (local_path.empty())
 	{
@@ -519,7 +782,7 @@ error_code sys_fs_stat(vm::cptr<char> path, vm::ptr<CellFsStat> sb)
 	if (!path)
 		return CELL_EFAULT;
 
-	const std::string local_path = vfs::get(path.get_ptr());
+	std::string local_path = vfs::get(path.get_ptr());
 
 	if (local_path.empty())
 	{
@@ -534,7 +797,7 @@ error_code sys_fs_stat(vm::cptr<char> path, vm::ptr<CellFsStat> sb)
 		return CELL_OK;
 	}
 
-	if (!fs::stat(local_path, info))
+	if (!vfs::stat(path.get_ptr(), local_path, info))
 	{
 		switch (auto error = fs::g_tls_error)
 		{
@@ -607,7 +870,12 @@ error_code sys_fs_mkdir(vm::cptr<char> path, s32 mode)
 		return {CELL_EEXIST, path};
 	}
 
-	if (!fs::create_path(local_path))
+	const bool created = fs::create_path(local_path);
+
+	// Invalidate after the host change (even a failed one may have created some directories)
+	vfs::invalidate(path.get_ptr());
+
+	if (!created)
 	{
 		switch (auto error = fs::g_tls_error)
 		{
@@ -640,7 +908,13 @@ error_code sys_fs_rename(vm::cptr<char> from, vm::cptr<char> to)
 		return CELL_EPERM;
 	}
 
-	if (!fs::rename(local_from, local_to, false))
+	const bool renamed = fs::rename(local_from, local_to, false);
+
+	// Invalidate after the host change
+	vfs::invalidate(from.get_ptr());
+	vfs::invalidate(to.get_ptr());
+
+	if (!renamed)
 	{
 		switch (auto error = fs::g_tls_error)
 		{
@@ -672,7 +946,12 @@ error_code sys_fs_rmdir(vm::cptr<char> path)
 		return {CELL_EPERM, path};
 	}
 
-	if (!fs::remove_dir(local_path))
+	const bool removed = fs::remove_dir(local_path);
+
+	// Invalidate after the host change
+	vfs::invalidate(path.get_ptr());
+
+	if (!removed)
 	{
 		switch (auto error = fs::g_tls_error)
 		{
@@ -710,7 +989,12 @@ error_code sys_fs_unlink(vm::cptr<char> path)
 		return {CELL_EISDIR, path};
 	}
 
-	if (!fs::remove_file(local_path))
+	const bool removed = fs::remove_file(local_path);
+
+	// Invalidate after the host change
+	vfs::invalidate(path.get_ptr());
+
+	if (!removed)
 	{
 		switch (auto error = fs::g_tls_error)
 		{
@@ -780,21 +1064,22 @@ error_code sys_fs_fcntl(u32 fd, u32 op, vm::ptr<void> _arg, u32 _size)
 			return CELL_EBADF;
 		}
 
-		std::lock_guard<std::mutex> lock(file->mp->mutex);
+		// Native files don't need the lock for reading at the offset
+		std::unique_lock<std::mutex> lock(file->mp->mutex, std::defer_lock);
+
+		if (op == 0x8000000b || !file->is_positional())
+		{
+			lock.lock();
+		}
 
 		if (op == 0x8000000b && file->lock)
 		{
 			return CELL_EBUSY;
 		}
 
-		const u64 old_pos = file->file.pos();
-		const u64 new_pos = file->file.seek(arg->offset);
-
 		arg->out_size = op == 0x8000000a
-			? file->op_read(arg->buf, arg->size)
-			: file->op_write(arg->buf, arg->size);
-
-		verify(HERE), old_pos == file->file.seek(old_pos);
+			? file->op_read_at(arg->offset, arg->buf, arg->size)
+			: file->op_write_at(arg->offset, arg->buf, arg->size);
 
 		arg->out_code = CELL_OK;
 		return CELL_OK;
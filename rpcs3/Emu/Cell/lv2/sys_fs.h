@@ -3,6 +3,8 @@
 #include "Emu/Memory/Memory.h"
 #include "Emu/Cell/ErrorCodes.h"
 
+#include <mutex>
+
 // Open Flags
 enum : s32
 {
@@ -160,20 +162,50 @@ struct lv2_fs_object
 	}
 };
 
+// Sequential read detection and read-ahead buffer
+struct lv2_file_prefetch
+{
+	std::mutex mutex;
+
+	u64 next = 0; // Expected offset of the next sequential read
+	u32 streak = 0; // Number of sequential reads in a row
+
+	// Two buffers from the global pool: one is being read from, the other is filled by the worker
+	std::unique_ptr<u8[]> buf;
+	std::unique_ptr<u8[]> spare;
+	u64 pos = 0; // File offset of the buffered data
+	u64 size = 0; // Size of the buffered data
+	u64 req_pos = 0; // Requested offset (while busy)
+	u64 req_size = 0; // Requested size (while busy)
+	bool busy = false;
+
+	u64 hits = 0; // Reads served from the buffer
+	u64 misses = 0; // Sequential reads not served from the buffer
+
+	~lv2_file_prefetch();
+};
+
 struct lv2_file final : lv2_fs_object
 {
 	const fs::file file;
 	const s32 mode;
 	const s32 flags;
 
+	// Memory mapped read-only file (read directly without intermediate buffer)
+	const bool mapped;
+
 	// Stream lock
 	atomic_t<u32> lock{0};
 
-	lv2_file(const char* filename, fs::file&& file, s32 mode, s32 flags)
+	// Read-ahead state (used by sys_fs_read)
+	lv2_file_prefetch prefetch;
+
+	lv2_file(const char* filename, fs::file&& file, s32 mode, s32 flags, bool mapped = false)
 		: lv2_fs_object(lv2_fs_object::get_mp(filename), filename)
 		, file(std::move(file))
 		, mode(mode)
 		, flags(flags)
+		, mapped(mapped)
 	{
 	}
 
@@ -182,6 +214,7 @@ struct lv2_file final : lv2_fs_object
 		, file(std::move(file))
 		, mode(mode)
 		, flags(flags)
+		, mapped(false)
 	{
 	}
 
@@ -191,6 +224,15 @@ struct lv2_file final : lv2_fs_object
 	// File writing with intermediate buffer
 	u64 op_write(vm::ps3::cptr<void> buf, u64 size);
 
+	// Check whether op_read_at/op_write_at don't touch the file position at all
+	bool is_positional() const;
+
+	// File reading at the specified offset (doesn't change file position)
+	u64 op_read_at(u64 offset, vm::ps3::ptr<void> buf, u64 size);
+
+	// File writing at the specified offset (doesn't change file position)
+	u64 op_write_at(u64 offset, vm::ps3::cptr<void> buf, u64 size);
+
 	// For MSELF support
 	struct file_view;
 
@@ -108,6 +108,7 @@ error_code _sys_lwcond_signal(ppu_thread& ppu, u32 lwcond_id, u32 lwmutex_id, u3
 
 				if (mode == 2)
 				{
+					cpu_reg_lock reg_lock(*result);
 					static_cast<ppu_thread*>(result)->gpr[3] = CELL_EBUSY;
 				}
 
@@ -184,6 +185,7 @@ error_code _sys_lwcond_signal_all(ppu_thread& ppu, u32 lwcond_id, u32 lwmutex_id
 
 				if (mode == 2)
 				{
+					cpu_reg_lock reg_lock(*cpu);
 					static_cast<ppu_thread*>(cpu)->gpr[3] = CELL_EBUSY;
 				}
 
@@ -300,11 +302,11 @@ error_code _sys_lwcond_queue_wait(ppu_thread& ppu, u32 lwcond_id, u32 lwmutex_id
 				break;
 			}
 
-			thread_ctrl::wait_for(timeout - passed);
+			ppu.cpu_wait(timeout - passed);
 		}
 		else
 		{
-			thread_ctrl::wait();
+			ppu.cpu_wait();
 		}
 	}
 
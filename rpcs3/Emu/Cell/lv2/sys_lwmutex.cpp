@@ -66,6 +66,11 @@ error_code _sys_lwmutex_destroy(u32 lwmutex_id)
 		return mutex.ret;
 	}
 
+	if (const u32 count = mutex->contended)
+	{
+		sys_lwmutex.notice("_sys_lwmutex_destroy(): lwmutex 0x%x was contended %u times", lwmutex_id, count);
+	}
+
 	return CELL_OK;
 }
 
@@ -94,6 +99,7 @@ error_code _sys_lwmutex_lock(ppu_thread& ppu, u32 lwmutex_id, u64 timeout)
 		}
 
 		mutex.sq.emplace_back(&ppu);
+		mutex.contended++;
 		mutex.sleep(ppu, timeout);
 		return false;
 	});
@@ -130,11 +136,11 @@ error_code _sys_lwmutex_lock(ppu_thread& ppu, u32 lwmutex_id, u64 timeout)
 				break;
 			}
 
-			thread_ctrl::wait_for(timeout - passed);
+			ppu.cpu_wait(timeout - passed);
 		}
 		else
 		{
-			thread_ctrl::wait();
+			ppu.cpu_wait();
 		}
 	}
 
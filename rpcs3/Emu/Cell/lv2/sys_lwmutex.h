@@ -59,6 +59,7 @@ struct lv2_lwmutex final : lv2_obj
 
 	semaphore<> mutex;
 	atomic_t<u32> signaled{0};
+	atomic_t<u32> contended{0}; // Number of times a thread had to sleep
 	std::deque<cpu_thread*> sq;
 
 	lv2_lwmutex(u32 protocol, vm::ps3::ptr<sys_lwmutex_t> control, u64 name)
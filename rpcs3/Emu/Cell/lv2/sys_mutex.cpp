@@ -103,6 +103,11 @@ error_code sys_mutex_destroy(u32 mutex_id)
 		return mutex.ret;
 	}
 
+	if (const u32 count = mutex->contended)
+	{
+		sys_mutex.notice("sys_mutex_destroy(): mutex 0x%x was contended %u times", mutex_id, count);
+	}
+
 	return CELL_OK;
 }
 
@@ -110,6 +115,27 @@ error_code sys_mutex_lock(ppu_thread& ppu, u32 mutex_id, u64 timeout)
 {
 	sys_mutex.trace("sys_mutex_lock(mutex_id=0x%x, timeout=0x%llx)", mutex_id, timeout);
 
+	// Fast path: lock-free lookup, only touch the owner field, don't take a reference
+	const auto fast = idm::check_lockfree<lv2_obj, lv2_mutex>(mutex_id, [&](lv2_mutex& mutex)
+	{
+		return mutex.try_lock(ppu.id);
+	});
+
+	if (!fast)
+	{
+		return CELL_ESRCH;
+	}
+
+	if (fast.ret != CELL_EBUSY)
+	{
+		if (fast.ret)
+		{
+			return fast.ret;
+		}
+
+		return CELL_OK;
+	}
+
 	const auto mutex = idm::get<lv2_obj, lv2_mutex>(mutex_id, [&](lv2_mutex& mutex)
 	{
 		CellError result = mutex.try_lock(ppu.id);
@@ -170,11 +196,11 @@ error_code sys_mutex_lock(ppu_thread& ppu, u32 mutex_id, u64 timeout)
 				break;
 			}
 
-			thread_ctrl::wait_for(timeout - passed);
+			ppu.cpu_wait(timeout - passed);
 		}
 		else
 		{
-			thread_ctrl::wait();
+			ppu.cpu_wait();
 		}
 	}
 
@@ -35,6 +35,7 @@ struct lv2_mutex final : lv2_obj
 	atomic_t<u32> owner{0}; // Owner Thread ID
 	atomic_t<u32> lock_count{0}; // Recursive Locks
 	atomic_t<u32> cond_count{0}; // Condition Variables
+	atomic_t<u32> contended{0}; // Number of times a thread had to sleep
 	std::deque<cpu_thread*> sq;
 
 	lv2_mutex(u32 protocol, u32 recursive, u32 shared, u32 adaptive, u64 key, s32 flags, u64 name)
@@ -95,6 +96,7 @@ struct lv2_mutex final : lv2_obj
 		}))
 		{
 			sq.emplace_back(&cpu);
+			contended++;
 			return false;
 		}
 
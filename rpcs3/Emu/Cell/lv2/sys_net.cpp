@@ -16,12 +16,18 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <sys/event.h>
+#endif
 #endif
 
 namespace vm { using namespace ps3; }
@@ -32,6 +38,13 @@ static std::vector<ppu_thread*> s_to_awake;
 
 static semaphore<> s_nw_mutex;
 
+// Readiness notification object of the network thread (epoll/kqueue descriptor or event handle)
+#ifdef _WIN32
+static HANDLE s_nw_reactor = nullptr;
+#else
+static int s_nw_reactor = -1;
+#endif
+
 extern u64 get_system_time();
 
 // Error helper functions
@@ -110,137 +123,231 @@ static void network_clear_queue(ppu_thread& ppu)
 	});
 }
 
-extern void network_thread_init()
+// Register socket in the network thread reactor (must be called once after the socket got its id)
+extern void network_register(u32 id, lv2_socket& sock)
 {
-	thread_ctrl::spawn("Network Thread", []()
+#ifdef _WIN32
+	verify(HERE), 0 == WSAEventSelect(sock.socket, s_nw_reactor, FD_READ | FD_ACCEPT | FD_CLOSE | FD_WRITE | FD_CONNECT);
+#elif defined(__linux__)
+	// Edge-triggered: waiters always retry the operation before being queued
+	::epoll_event ev{};
+	ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+	ev.data.u64 = u64{id} | u64(u32(sock.socket)) << 32;
+	verify(HERE), 0 == ::epoll_ctl(s_nw_reactor, EPOLL_CTL_ADD, sock.socket, &ev);
+#else
+	struct ::kevent ev[2];
+	EV_SET(&ev[0], sock.socket, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, reinterpret_cast<void*>(std::uintptr_t{id}));
+	EV_SET(&ev[1], sock.socket, EVFILT_WRITE, EV_ADD | EV_CLEAR, 0, 0, reinterpret_cast<void*>(std::uintptr_t{id}));
+	verify(HERE), 0 == ::kevent(s_nw_reactor, ev, 2, nullptr, 0, nullptr);
+#endif
+}
+
+// Check whether the connection is still being established (after the socket reported writability)
+static bool network_connect_pending(lv2_socket& sock)
+{
+#ifdef _WIN32
+	// FD_CONNECT is only signaled when the attempt completes
+	return false;
+#else
+	// The write edge may have been reported before the connection was initiated
+	::sockaddr_storage native_addr;
+	::socklen_t native_addrlen = sizeof(native_addr);
+	return ::getpeername(sock.socket, (::sockaddr*)&native_addr, &native_addrlen) != 0 && errno == ENOTCONN;
+#endif
+}
+
+// Run queued event processing functions of the socket (s_nw_mutex must be locked)
+static void network_dispatch(lv2_socket& sock, bs_t<lv2_socket::poll> ready)
+{
+	semaphore_lock lock(sock.mutex);
+
+	bs_t<lv2_socket::poll> events{};
+
+	if (test(ready, lv2_socket::poll::read) && sock.events.test_and_reset(lv2_socket::poll::read))
+		events += lv2_socket::poll::read;
+	if (test(ready, lv2_socket::poll::write) && sock.events.test_and_reset(lv2_socket::poll::write))
+		events += lv2_socket::poll::write;
+	if (test(ready, lv2_socket::poll::error) && sock.events.test_and_reset(lv2_socket::poll::error))
+		events += lv2_socket::poll::error;
+
+	if (!test(events))
+	{
+		return;
+	}
+
+	for (auto it = sock.queue.begin(); test(events) && it != sock.queue.end();)
 	{
-		std::vector<std::shared_ptr<lv2_socket>> socklist;
-		socklist.reserve(lv2_socket::id_count);
+		if (it->second(events))
+		{
+			it = sock.queue.erase(it);
+			continue;
+		}
 
-		s_to_awake.clear();
+		it++;
+	}
 
+	if (sock.queue.empty())
+	{
+		sock.events = {};
+	}
+}
+
+// Create the reactor (must be called before any socket is registered)
+extern void network_reactor_init()
+{
 #ifdef _WIN32
-		HANDLE _eventh = CreateEventW(nullptr, false, false, nullptr);
+	WSADATA wsa_data;
+	WSAStartup(MAKEWORD(2, 2), &wsa_data);
 
-		WSADATA wsa_data;
-		WSAStartup(MAKEWORD(2, 2), &wsa_data);
+	s_nw_reactor = CreateEventW(nullptr, false, false, nullptr);
+	verify(HERE), s_nw_reactor;
+#else
+#ifdef __linux__
+	s_nw_reactor = ::epoll_create1(EPOLL_CLOEXEC);
 #else
-		::pollfd fds[lv2_socket::id_count]{};
+	s_nw_reactor = ::kqueue();
+#endif
+	verify(HERE), s_nw_reactor != -1;
 #endif
+}
 
-		do
-		{
-			// Wait with 1ms timeout
+extern void network_reactor_close()
+{
 #ifdef _WIN32
-			WaitForSingleObjectEx(_eventh, 1, false);
+	CloseHandle(s_nw_reactor);
+	s_nw_reactor = nullptr;
+	WSACleanup();
 #else
-			::poll(fds, socklist.size(), 1);
+	::close(s_nw_reactor);
+	s_nw_reactor = -1;
 #endif
+}
 
-			semaphore_lock lock(s_nw_mutex);
+// Wait for socket readiness (up to timeout ms) and dispatch it to the queued waiters
+extern void network_reactor_wait(u32 timeout)
+{
+#ifdef _WIN32
+	WaitForSingleObjectEx(s_nw_reactor, timeout, false);
+#elif defined(__linux__)
+	std::array<::epoll_event, 64> evs;
 
-			for (std::size_t i = 0; i < socklist.size(); i++)
-			{
-				bs_t<lv2_socket::poll> events{};
+	const int count = ::epoll_wait(s_nw_reactor, evs.data(), ::size32(evs), timeout);
+#else
+	std::array<struct ::kevent, 64> evs;
+
+	const ::timespec ts{timeout / 1000, timeout % 1000 * 1000 * 1000};
+	const int count = ::kevent(s_nw_reactor, nullptr, 0, evs.data(), ::size32(evs), &ts);
+#endif
 
-				lv2_socket& sock = *socklist[i];
+	semaphore_lock lock(s_nw_mutex);
 
 #ifdef _WIN32
-				WSANETWORKEVENTS nwe;
-				if (WSAEnumNetworkEvents(sock.socket, nullptr, &nwe) == 0)
-				{
-					sock.ev_set |= nwe.lNetworkEvents;
-
-					if (sock.ev_set & (FD_READ | FD_ACCEPT | FD_CLOSE) && sock.events.test_and_reset(lv2_socket::poll::read))
-						events += lv2_socket::poll::read;
-					if (sock.ev_set & (FD_WRITE | FD_CONNECT) && sock.events.test_and_reset(lv2_socket::poll::write))
-						events += lv2_socket::poll::write;
-
-					if ((nwe.lNetworkEvents & FD_READ && nwe.iErrorCode[FD_READ_BIT]) ||
-						(nwe.lNetworkEvents & FD_ACCEPT && nwe.iErrorCode[FD_ACCEPT_BIT]) ||
-						(nwe.lNetworkEvents & FD_CLOSE && nwe.iErrorCode[FD_CLOSE_BIT]) ||
-						(nwe.lNetworkEvents & FD_WRITE && nwe.iErrorCode[FD_WRITE_BIT]) ||
-						(nwe.lNetworkEvents & FD_CONNECT && nwe.iErrorCode[FD_CONNECT_BIT]))
-					{
-						// TODO
-						if (sock.events.test_and_reset(lv2_socket::poll::error))
-							events += lv2_socket::poll::error;
-					}
-				}
-				else
-				{
-					sys_net.error("WSAEnumNetworkEvents() failed (s=%d)", i);
-				}
-#else
-				if (fds[i].revents & (POLLIN | POLLHUP) && socklist[i]->events.test_and_reset(lv2_socket::poll::read))
-					events += lv2_socket::poll::read;
-				if (fds[i].revents & POLLOUT && socklist[i]->events.test_and_reset(lv2_socket::poll::write))
-					events += lv2_socket::poll::write;
-				if (fds[i].revents & POLLERR && socklist[i]->events.test_and_reset(lv2_socket::poll::error))
-					events += lv2_socket::poll::error;
-#endif
+	// Event handle doesn't tell which socket is signaled
+	std::vector<std::shared_ptr<lv2_socket>> socklist;
 
-				if (test(events))
-				{
-					semaphore_lock lock(socklist[i]->mutex);
+	idm::select<lv2_socket>([&](u32 id, lv2_socket&)
+	{
+		socklist.emplace_back(idm::get_unlocked<lv2_socket>(id));
+	});
 
-					for (auto it = socklist[i]->queue.begin(); test(events) && it != socklist[i]->queue.end();)
-					{
-						if (it->second(events))
-						{
-							it = socklist[i]->queue.erase(it);
-							continue;
-						}
+	for (std::size_t i = 0; i < socklist.size(); i++)
+	{
+		bs_t<lv2_socket::poll> ready{};
 
-						it++;
-					}
+		lv2_socket& sock = *socklist[i];
 
-					if (socklist[i]->queue.empty())
-					{
-						socklist[i]->events = {};
-					}
-				}
-			}
+		WSANETWORKEVENTS nwe;
+		if (WSAEnumNetworkEvents(sock.socket, nullptr, &nwe) == 0)
+		{
+			sock.ev_set |= nwe.lNetworkEvents;
 
-			s_to_awake.erase(std::unique(s_to_awake.begin(), s_to_awake.end()), s_to_awake.end());
+			if (sock.ev_set & (FD_READ | FD_ACCEPT | FD_CLOSE))
+				ready += lv2_socket::poll::read;
+			if (sock.ev_set & (FD_WRITE | FD_CONNECT))
+				ready += lv2_socket::poll::write;
 
-			for (ppu_thread* ppu : s_to_awake)
+			if ((nwe.lNetworkEvents & FD_READ && nwe.iErrorCode[FD_READ_BIT]) ||
+				(nwe.lNetworkEvents & FD_ACCEPT && nwe.iErrorCode[FD_ACCEPT_BIT]) ||
+				(nwe.lNetworkEvents & FD_CLOSE && nwe.iErrorCode[FD_CLOSE_BIT]) ||
+				(nwe.lNetworkEvents & FD_WRITE && nwe.iErrorCode[FD_WRITE_BIT]) ||
+				(nwe.lNetworkEvents & FD_CONNECT && nwe.iErrorCode[FD_CONNECT_BIT]))
 			{
-				network_clear_queue(*ppu);
-				lv2_obj::awake(*ppu);
+				// TODO
+				ready += lv2_socket::poll::error;
 			}
+		}
+		else
+		{
+			sys_net.error("WSAEnumNetworkEvents() failed (s=%d)", i);
+		}
 
-			s_to_awake.clear();
-			socklist.clear();
+		if (test(ready))
+		{
+			network_dispatch(sock, ready);
+		}
+	}
+#else
+	for (int i = 0; i < count; i++)
+	{
+		bs_t<lv2_socket::poll> ready{};
+#ifdef __linux__
+		const u32 id = static_cast<u32>(evs[i].data.u64);
+		const int fd = static_cast<int>(evs[i].data.u64 >> 32);
+
+		if (evs[i].events & (EPOLLIN | EPOLLHUP | EPOLLRDHUP))
+			ready += lv2_socket::poll::read;
+		if (evs[i].events & EPOLLOUT)
+			ready += lv2_socket::poll::write;
+		if (evs[i].events & EPOLLERR)
+			ready += lv2_socket::poll::error;
+#else
+		const u32 id = static_cast<u32>(reinterpret_cast<std::uintptr_t>(evs[i].udata));
+		const int fd = static_cast<int>(evs[i].ident);
+
+		if (evs[i].filter == EVFILT_READ)
+			ready += lv2_socket::poll::read;
+		if (evs[i].filter == EVFILT_WRITE)
+			ready += lv2_socket::poll::write;
+		if (evs[i].flags & EV_ERROR || (evs[i].flags & EV_EOF && evs[i].fflags))
+			ready += lv2_socket::poll::error;
+#endif
+		const auto sock = idm::get<lv2_socket>(id);
 
-			// Obtain all active sockets
-			idm::select<lv2_socket>([&](u32 id, lv2_socket&)
-			{
-				socklist.emplace_back(idm::get_unlocked<lv2_socket>(id));
-			});
+		// Skip events of sockets which were closed meanwhile (the id may have been reused)
+		if (sock && sock->socket == fd)
+		{
+			network_dispatch(*sock, ready);
+		}
+	}
+#endif
 
-			for (std::size_t i = 0; i < socklist.size(); i++)
-			{
-				auto events = socklist[i]->events.load();
+	s_to_awake.erase(std::unique(s_to_awake.begin(), s_to_awake.end()), s_to_awake.end());
 
-#ifdef _WIN32
-				verify(HERE), 0 == WSAEventSelect(socklist[i]->socket, _eventh, FD_READ | FD_ACCEPT | FD_CLOSE | FD_WRITE | FD_CONNECT);
-#else
-				fds[i].fd = test(events) ? socklist[i]->socket : -1;
-				fds[i].events =
-					(test(events, lv2_socket::poll::read) ? POLLIN : 0) |
-					(test(events, lv2_socket::poll::write) ? POLLOUT : 0) |
-					0;
-				fds[i].revents = 0;
-#endif
-			}
+	for (ppu_thread* ppu : s_to_awake)
+	{
+		network_clear_queue(*ppu);
+		lv2_obj::awake(*ppu);
+	}
+
+	s_to_awake.clear();
+}
+
+extern void network_thread_init()
+{
+	network_reactor_init();
+
+	thread_ctrl::spawn("Network Thread", []()
+	{
+		s_to_awake.clear();
+
+		do
+		{
+			// Sleep until some socket becomes ready (the timeout is only used to notice emulation stop)
+			network_reactor_wait(100);
 		}
 		while (!Emu.IsStopped());
 
-#ifdef _WIN32
-		CloseHandle(_eventh);
-		WSACleanup();
-#endif
+		network_reactor_close();
 	});
 }
 
@@ -338,7 +445,7 @@ s32 sys_net_bnet_accept(ppu_thread& ppu, s32 s, vm::ptr<sys_net_sockaddr> addr,
 	{
 		while (!ppu.state.test_and_reset(cpu_flag::signal))
 		{
-			thread_ctrl::wait();
+			ppu.cpu_wait();
 		}
 
 		if (result)
@@ -361,6 +468,8 @@ s32 sys_net_bnet_accept(ppu_thread& ppu, s32 s, vm::ptr<sys_net_sockaddr> addr,
 		return -SYS_NET_EMFILE;
 	}
 
+	network_register(result, *newsock);
+
 	if (addr)
 	{
 		verify(HERE), native_addr.ss_family == AF_INET;
@@ -483,6 +592,11 @@ s32 sys_net_bnet_connect(ppu_thread& ppu, s32 s, vm::ptr<sys_net_sockaddr> addr,
 						{
 							sock.so_error = 1;
 						}
+						else if (!native_error && network_connect_pending(sock))
+						{
+							sock.events += lv2_socket::poll::write;
+							return false;
+						}
 						else
 						{
 							// TODO: check error formats (both native and translated)
@@ -514,6 +628,11 @@ s32 sys_net_bnet_connect(ppu_thread& ppu, s32 s, vm::ptr<sys_net_sockaddr> addr,
 				{
 					result = 1;
 				}
+				else if (!native_error && network_connect_pending(sock))
+				{
+					sock.events += lv2_socket::poll::write;
+					return false;
+				}
 				else
 				{
 					// TODO: check error formats (both native and translated)
@@ -546,7 +665,7 @@ s32 sys_net_bnet_connect(ppu_thread& ppu, s32 s, vm::ptr<sys_net_sockaddr> addr,
 	{
 		while (!ppu.state.test_and_reset(cpu_flag::signal))
 		{
-			thread_ctrl::wait();
+			ppu.cpu_wait();
 		}
 
 		if (result)
@@ -863,7 +982,7 @@ s32 sys_net_bnet_recvfrom(ppu_thread& ppu, s32 s, vm::ptr<void> buf, u32 len, s3
 
 	if (flags & ~(SYS_NET_MSG_PEEK | SYS_NET_MSG_DONTWAIT | SYS_NET_MSG_WAITALL))
 	{
-		fmt::throw_exception("sys_net_bnet_recvfrom(s=%d): unknown flags (0x%x)", flags);
+		fmt::throw_exception("sys_net_bnet_recvfrom(s=%d): unknown flags (0x%x)", s, flags);
 	}
 
 	int native_flags = 0;
@@ -891,6 +1010,8 @@ s32 sys_net_bnet_recvfrom(ppu_thread& ppu, s32 s, vm::ptr<void> buf, u32 len, s3
 #ifdef _WIN32
 			if (!(native_flags & MSG_PEEK)) sock.ev_set &= ~FD_READ;
 #endif
+			// Received directly into guest memory (host OS writes must not hit armed dirty tracked pages)
+			vm::dirty_host_write dirty(buf.addr(), len);
 			native_result = ::recvfrom(sock.socket, (char*)buf.get_ptr(), len, native_flags, (::sockaddr*)&native_addr, &native_addrlen);
 
 			if (native_result >= 0)
@@ -915,6 +1036,7 @@ s32 sys_net_bnet_recvfrom(ppu_thread& ppu, s32 s, vm::ptr<void> buf, u32 len, s3
 #ifdef _WIN32
 				if (!(native_flags & MSG_PEEK)) sock.ev_set &= ~FD_READ;
 #endif
+				vm::dirty_host_write dirty(buf.addr(), len);
 				native_result = ::recvfrom(sock.socket, (char*)buf.get_ptr(), len, native_flags, (::sockaddr*)&native_addr, &native_addrlen);
 
 				if (native_result >= 0 || (result = get_last_error(!sock.so_nbio && (flags & SYS_NET_MSG_DONTWAIT) == 0)))
@@ -946,7 +1068,7 @@ s32 sys_net_bnet_recvfrom(ppu_thread& ppu, s32 s, vm::ptr<void> buf, u32 len, s3
 	{
 		while (!ppu.state.test_and_reset(cpu_flag::signal))
 		{
-			thread_ctrl::wait();
+			ppu.cpu_wait();
 		}
 
 		if (result)
@@ -983,16 +1105,395 @@ s32 sys_net_bnet_recvfrom(ppu_thread& ppu, s32 s, vm::ptr<void> buf, u32 len, s3
 	return native_result;
 }
 
-s32 sys_net_bnet_recvmsg(ppu_thread& ppu, s32 s, vm::ptr<sys_net_msghdr> msg, s32 flags)
+#ifdef _WIN32
+using native_iovec = ::WSABUF;
+#else
+using native_iovec = ::iovec;
+#endif
+
+// Make host iovec array pointing directly to guest buffers (the guest iovec array is read once), return error code
+static s32 network_make_iov(const sys_net_msghdr& msg, std::vector<native_iovec>& iov, u8 flags)
 {
-	sys_net.todo("sys_net_bnet_recvmsg(s=%d, msg=*0x%x, flags=0x%x)", s, msg, flags);
+	const s32 count = msg.msg_iovlen;
+	const vm::ptr<sys_net_iovec> src = msg.msg_iov;
+
+	if (count < 0 || count > 1024 || (count && !src))
+	{
+		return SYS_NET_EINVAL;
+	}
+
+	if (count && !vm::check_addr(src.addr(), count * sizeof(sys_net_iovec)))
+	{
+		return SYS_NET_EFAULT;
+	}
+
+	iov.resize(count);
+
+	for (s32 i = 0; i < count; i++)
+	{
+		const u32 addr = src[i].iov_base.addr();
+		const u32 size = src[i].iov_len;
+
+		if (size && (u64{addr} + size > 0x100000000 || !vm::check_addr(addr, size, flags)))
+		{
+			return SYS_NET_EFAULT;
+		}
+#ifdef _WIN32
+		iov[i].buf = static_cast<char*>(vm::base(addr));
+		iov[i].len = size;
+#else
+		iov[i].iov_base = vm::base(addr);
+		iov[i].iov_len = size;
+#endif
+	}
+
 	return 0;
 }
 
+s32 sys_net_bnet_recvmsg(ppu_thread& ppu, s32 s, vm::ptr<sys_net_msghdr> msg, s32 flags)
+{
+	sys_net.warning("sys_net_bnet_recvmsg(s=%d, msg=*0x%x, flags=0x%x)", s, msg, flags);
+
+	if (flags & ~(SYS_NET_MSG_PEEK | SYS_NET_MSG_DONTWAIT | SYS_NET_MSG_WAITALL))
+	{
+		fmt::throw_exception("sys_net_bnet_recvmsg(s=%d): unknown flags (0x%x)", s, flags);
+	}
+
+	std::vector<native_iovec> iov;
+
+	if (!msg)
+	{
+		return -SYS_NET_EINVAL;
+	}
+
+	if (const s32 error = network_make_iov(*msg, iov, vm::page_allocated | vm::page_writable))
+	{
+		return -error;
+	}
+
+	if (msg->msg_control)
+	{
+		sys_net.error("sys_net_bnet_recvmsg(s=%d): msg_control not implemented", s);
+	}
+
+	int native_flags = 0;
+	int native_result = -1;
+	int native_msg_flags = 0;
+	::sockaddr_storage native_addr;
+	::socklen_t native_addrlen = sizeof(native_addr);
+	s32 result = 0;
+
+	if (flags & SYS_NET_MSG_PEEK)
+	{
+		native_flags |= MSG_PEEK;
+	}
+
+	if (flags & SYS_NET_MSG_WAITALL)
+	{
+		native_flags |= MSG_WAITALL;
+	}
+
+	// Receive directly into guest memory (host OS writes must not hit armed dirty tracked pages)
+	auto native_recv = [&](lv2_socket& sock) -> int
+	{
+		vm::dirty_host_write dirty;
+
+		for (const native_iovec& buf : iov)
+		{
+#ifdef _WIN32
+			dirty.add(vm::get_addr(buf.buf), buf.len);
+#else
+			dirty.add(vm::get_addr(buf.iov_base), static_cast<u32>(buf.iov_len));
+#endif
+		}
+
+		native_addrlen = sizeof(native_addr);
+#ifdef _WIN32
+		if (!(native_flags & MSG_PEEK)) sock.ev_set &= ~FD_READ;
+
+		DWORD bytes = 0;
+		DWORD wsa_flags = native_flags;
+
+		if (::WSARecvFrom(sock.socket, iov.data(), ::size32(iov), &bytes, &wsa_flags, (::sockaddr*)&native_addr, &native_addrlen, nullptr, nullptr) != 0)
+		{
+			return -1;
+		}
+
+		native_msg_flags = wsa_flags;
+		return bytes;
+#else
+		::msghdr native_msg{};
+		native_msg.msg_name = &native_addr;
+		native_msg.msg_namelen = native_addrlen;
+		native_msg.msg_iov = iov.data();
+		native_msg.msg_iovlen = iov.size();
+
+		const int r = ::recvmsg(sock.socket, &native_msg, native_flags);
+		native_addrlen = native_msg.msg_namelen;
+		native_msg_flags = native_msg.msg_flags;
+		return r;
+#endif
+	};
+
+	const auto sock = idm::check<lv2_socket>(s, [&](lv2_socket& sock)
+	{
+		semaphore_lock lock(sock.mutex);
+
+		//if (!test(sock.events, lv2_socket::poll::read))
+		{
+			native_result = native_recv(sock);
+
+			if (native_result >= 0)
+			{
+				return true;
+			}
+
+			result = get_last_error(!sock.so_nbio && (flags & SYS_NET_MSG_DONTWAIT) == 0);
+
+			if (result)
+			{
+				return false;
+			}
+		}
+
+		// Enable read event
+		sock.events += lv2_socket::poll::read;
+		sock.queue.emplace_back(ppu.id, [&](bs_t<lv2_socket::poll> events) -> bool
+		{
+			if (test(events, lv2_socket::poll::read))
+			{
+				native_result = native_recv(sock);
+
+				if (native_result >= 0 || (result = get_last_error(!sock.so_nbio && (flags & SYS_NET_MSG_DONTWAIT) == 0)))
+				{
+					lv2_obj::awake(ppu);
+					return true;
+				}
+			}
+
+			sock.events += lv2_socket::poll::read;
+			return false;
+		});
+
+		lv2_obj::sleep(ppu);
+		return false;
+	});
+
+	if (!sock)
+	{
+		return -SYS_NET_EBADF;
+	}
+
+	if (!sock.ret && result)
+	{
+		return -result;
+	}
+
+	if (!sock.ret)
+	{
+		while (!ppu.state.test_and_reset(cpu_flag::signal))
+		{
+			ppu.cpu_wait();
+		}
+
+		if (result)
+		{
+			return -result;
+		}
+
+		if (ppu.gpr[3] == -SYS_NET_EINTR)
+		{
+			return -SYS_NET_EINTR;
+		}
+	}
+
+	// TODO
+	if (msg->msg_name && msg->msg_namelen >= sizeof(sys_net_sockaddr_in) && native_addrlen && native_addr.ss_family == AF_INET)
+	{
+		vm::ptr<sys_net_sockaddr_in> paddr = vm::cast(msg->msg_name.addr());
+
+		paddr->sin_len    = sizeof(sys_net_sockaddr_in);
+		paddr->sin_family = SYS_NET_AF_INET;
+		paddr->sin_port   = ntohs(((::sockaddr_in*)&native_addr)->sin_port);
+		paddr->sin_addr   = ntohl(((::sockaddr_in*)&native_addr)->sin_addr.s_addr);
+		paddr->sin_zero   = 0;
+
+		msg->msg_namelen = sizeof(sys_net_sockaddr_in);
+	}
+	else
+	{
+		msg->msg_namelen = 0;
+	}
+
+	msg->msg_controllen = 0;
+#ifdef _WIN32
+	msg->msg_flags = 0;
+#else
+	msg->msg_flags = native_msg_flags & MSG_TRUNC ? SYS_NET_MSG_TRUNC : 0;
+#endif
+
+	// Length
+	return native_result;
+}
+
 s32 sys_net_bnet_sendmsg(ppu_thread& ppu, s32 s, vm::cptr<sys_net_msghdr> msg, s32 flags)
 {
-	sys_net.todo("sys_net_bnet_sendmsg(s=%d, msg=*0x%x, flags=0x%x)", s, msg, flags);
-	return 0;
+	sys_net.warning("sys_net_bnet_sendmsg(s=%d, msg=*0x%x, flags=0x%x)", s, msg, flags);
+
+	if (flags & ~(SYS_NET_MSG_DONTWAIT | SYS_NET_MSG_WAITALL))
+	{
+		fmt::throw_exception("sys_net_bnet_sendmsg(s=%d): unknown flags (0x%x)", s, flags);
+	}
+
+	std::vector<native_iovec> iov;
+
+	if (!msg)
+	{
+		return -SYS_NET_EINVAL;
+	}
+
+	if (const s32 error = network_make_iov(*msg, iov, vm::page_allocated | vm::page_readable))
+	{
+		return -error;
+	}
+
+	const vm::cptr<sys_net_sockaddr> addr = vm::cast(msg->msg_name.addr());
+
+	if (addr && msg->msg_namelen < 8)
+	{
+		sys_net.error("sys_net_bnet_sendmsg(s=%d): bad msg_namelen (%u)", s, msg->msg_namelen);
+		return -SYS_NET_EINVAL;
+	}
+
+	if (addr && addr->sa_family != SYS_NET_AF_INET)
+	{
+		sys_net.error("sys_net_bnet_sendmsg(s=%d): unsupported sa_family (%d)", s, addr->sa_family);
+		return -SYS_NET_EAFNOSUPPORT;
+	}
+
+	if (msg->msg_control)
+	{
+		sys_net.error("sys_net_bnet_sendmsg(s=%d): msg_control not implemented", s);
+	}
+
+	int native_flags = 0;
+	int native_result = -1;
+	::sockaddr_in name{};
+
+	if (addr)
+	{
+		name.sin_family      = AF_INET;
+		name.sin_port        = htons(((sys_net_sockaddr_in*)addr.get_ptr())->sin_port);
+		name.sin_addr.s_addr = htonl(((sys_net_sockaddr_in*)addr.get_ptr())->sin_addr);
+	}
+
+	::socklen_t namelen = sizeof(name);
+	s32 result = 0;
+
+	if (flags & SYS_NET_MSG_WAITALL)
+	{
+		native_flags |= MSG_WAITALL;
+	}
+
+	// Send directly from guest memory
+	auto native_send = [&](lv2_socket& sock) -> int
+	{
+#ifdef _WIN32
+		sock.ev_set &= ~FD_WRITE;
+
+		DWORD bytes = 0;
+
+		if (::WSASendTo(sock.socket, iov.data(), ::size32(iov), &bytes, native_flags, addr ? (::sockaddr*)&name : nullptr, addr ? namelen : 0, nullptr, nullptr) != 0)
+		{
+			return -1;
+		}
+
+		return bytes;
+#else
+		::msghdr native_msg{};
+		native_msg.msg_name = addr ? &name : nullptr;
+		native_msg.msg_namelen = addr ? namelen : 0;
+		native_msg.msg_iov = iov.data();
+		native_msg.msg_iovlen = iov.size();
+
+		return ::sendmsg(sock.socket, &native_msg, native_flags);
+#endif
+	};
+
+	const auto sock = idm::check<lv2_socket>(s, [&](lv2_socket& sock)
+	{
+		semaphore_lock lock(sock.mutex);
+
+		//if (!test(sock.events, lv2_socket::poll::write))
+		{
+			native_result = native_send(sock);
+
+			if (native_result >= 0)
+			{
+				return true;
+			}
+
+			result = get_last_error(!sock.so_nbio && (flags & SYS_NET_MSG_DONTWAIT) == 0);
+
+			if (result)
+			{
+				return false;
+			}
+		}
+
+		// Enable write event
+		sock.events += lv2_socket::poll::write;
+		sock.queue.emplace_back(ppu.id, [&](bs_t<lv2_socket::poll> events) -> bool
+		{
+			if (test(events, lv2_socket::poll::write))
+			{
+				native_result = native_send(sock);
+
+				if (native_result >= 0 || (result = get_last_error(!sock.so_nbio && (flags & SYS_NET_MSG_DONTWAIT) == 0)))
+				{
+					lv2_obj::awake(ppu);
+					return true;
+				}
+			}
+
+			sock.events += lv2_socket::poll::write;
+			return false;
+		});
+
+		lv2_obj::sleep(ppu);
+		return false;
+	});
+
+	if (!sock)
+	{
+		return -SYS_NET_EBADF;
+	}
+
+	if (!sock.ret && result)
+	{
+		return -result;
+	}
+
+	if (!sock.ret)
+	{
+		while (!ppu.state.test_and_reset(cpu_flag::signal))
+		{
+			ppu.cpu_wait();
+		}
+
+		if (result)
+		{
+			return -result;
+		}
+
+		if (ppu.gpr[3] == -SYS_NET_EINTR)
+		{
+			return -SYS_NET_EINTR;
+		}
+	}
+
+	// Length
+	return native_result;
 }
 
 s32 sys_net_bnet_sendto(ppu_thread& ppu, s32 s, vm::cptr<void> buf, u32 len, s32 flags, vm::cptr<sys_net_sockaddr> addr, u32 addrlen)
@@ -1001,7 +1502,7 @@ s32 sys_net_bnet_sendto(ppu_thread& ppu, s32 s, vm::cptr<void> buf, u32 len, s32
 
 	if (flags & ~(SYS_NET_MSG_DONTWAIT | SYS_NET_MSG_WAITALL))
 	{
-		fmt::throw_exception("sys_net_bnet_sendto(s=%d): unknown flags (0x%x)", flags);
+		fmt::throw_exception("sys_net_bnet_sendto(s=%d): unknown flags (0x%x)", s, flags);
 	}
 
 	if (addr && addrlen < 8)
@@ -1099,7 +1600,7 @@ s32 sys_net_bnet_sendto(ppu_thread& ppu, s32 s, vm::cptr<void> buf, u32 len, s32
 	{
 		while (!ppu.state.test_and_reset(cpu_flag::signal))
 		{
-			thread_ctrl::wait();
+			ppu.cpu_wait();
 		}
 
 		if (result)
@@ -1384,13 +1885,17 @@ s32 sys_net_bnet_socket(ppu_thread& ppu, s32 family, s32 type, s32 protocol)
 		return -get_last_error(false);
 	}
 
-	const s32 s = idm::import_existing<lv2_socket>(std::make_shared<lv2_socket>(native_socket));
+	const auto sock = std::make_shared<lv2_socket>(native_socket);
+
+	const s32 s = idm::import_existing<lv2_socket>(sock);
 
 	if (s == id_manager::id_traits<lv2_socket>::invalid)
 	{
 		return -SYS_NET_EMFILE;
 	}
 
+	network_register(s, *sock);
+
 	return s;
 }
 
@@ -1564,11 +2069,11 @@ s32 sys_net_bnet_poll(ppu_thread& ppu, vm::ptr<sys_net_pollfd> fds, s32 nfds, s3
 				break;
 			}
 
-			thread_ctrl::wait_for(timeout - passed);
+			ppu.cpu_wait(timeout - passed);
 		}
 		else
 		{
-			thread_ctrl::wait();
+			ppu.cpu_wait();
 		}
 	}
 
@@ -1758,11 +2263,11 @@ s32 sys_net_bnet_select(ppu_thread& ppu, s32 nfds, vm::ptr<sys_net_fd_set> readf
 				break;
 			}
 
-			thread_ctrl::wait_for(timeout - passed);
+			ppu.cpu_wait(timeout - passed);
 		}
 		else
 		{
-			thread_ctrl::wait();
+			ppu.cpu_wait();
 		}
 	}
 
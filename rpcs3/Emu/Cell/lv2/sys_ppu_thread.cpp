@@ -202,19 +202,21 @@ error_code sys_ppu_thread_set_priority(ppu_thread& ppu, u32 thread_id, s32 prio)
 		return CELL_EINVAL;
 	}
 
-	const auto thread = idm::check<ppu_thread>(thread_id, [&](ppu_thread& thread)
-	{
-		if (thread.prio != prio && thread.prio.exchange(prio) != prio)
-		{
-			lv2_obj::awake(thread, prio);
-		}
-	});
+	const auto thread = idm::get<ppu_thread>(thread_id);
 
 	if (!thread)
 	{
 		return CELL_ESRCH;
 	}
 
+	// Priority is a part of the thread context
+	cpu_reg_lock reg_lock(*thread);
+
+	if (thread->prio != prio && thread->prio.exchange(prio) != prio)
+	{
+		lv2_obj::awake(*thread, prio);
+	}
+
 	return CELL_OK;
 }
 
@@ -360,7 +362,7 @@ error_code sys_ppu_thread_start(ppu_thread& ppu, u32 thread_id)
 				return (eq.name == "_mxr000\0"_u64) || (eq.key == 0x8000cafe02460300);
 			}))
 			{
-				thread_ctrl::wait_for(50000);
+				ppu.cpu_wait(50000);
 			}
 
 			ppu.test_state();
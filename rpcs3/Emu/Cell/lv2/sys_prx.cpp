@@ -13,6 +13,7 @@
 namespace vm { using namespace ps3; }
 
 extern std::shared_ptr<lv2_prx> ppu_load_prx(const ppu_prx_object&, const std::string&);
+extern fs::file ppu_decrypt_prx(fs::file, const std::string&, u8*);
 extern void ppu_unload_prx(const lv2_prx& prx);
 extern void ppu_initialize(const ppu_module&);
 
@@ -129,7 +130,7 @@ static error_code prx_load_module(const std::string& vpath, u64 flags, vm::ptr<s
 		src.open(path);
 	}
 
-	const ppu_prx_object obj = decrypt_self(std::move(src), fxm::get_always<LoadedNpdrmKeys_t>()->devKlic.data());
+	const ppu_prx_object obj = ppu_decrypt_prx(std::move(src), path, fxm::get_always<LoadedNpdrmKeys_t>()->devKlic.data());
 
 	if (obj != elf_error::ok)
 	{
@@ -388,6 +388,8 @@ error_code sys_spu_thread_group_start(ppu_thread& ppu, u32 id)
 
 			sys_spu_image::deploy(thread->offset, img.second.data(), img.first.nsegs);
 
+			cpu_reg_lock reg_lock(*thread);
+
 			thread->pc = img.first.entry_point;
 			thread->cpu_init();
 			thread->gpr[3] = v128::from64(0, args[0]);
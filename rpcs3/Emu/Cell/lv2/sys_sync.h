@@ -211,14 +211,11 @@ private:
 	// Scheduler mutex
 	static semaphore<> g_mutex;
 
-	// Scheduler queue for active PPU threads
-	static std::deque<class ppu_thread*> g_ppu;
+	// Scheduler queue for active PPU threads (priority order, FIFO for the same priority)
+	static struct ppu_run_queue g_ppu;
 
 	// Waiting for the response from
 	static std::deque<class cpu_thread*> g_pending;
 
-	// Scheduler queue for timeouts (wait until -> thread)
-	static std::deque<std::pair<u64, named_thread*>> g_waiting;
-
 	static void schedule_all();
 };
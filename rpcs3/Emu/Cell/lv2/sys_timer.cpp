@@ -10,6 +10,7 @@
 #include "sys_timer.h"
 
 #include <thread>
+#include <unordered_map>
 
 namespace vm { using namespace ps3; }
 
@@ -17,59 +18,382 @@ logs::channel sys_timer("sys_timer");
 
 extern u64 get_system_time();
 
-void lv2_timer::on_task()
+// Hierarchical timer wheel: 6 levels of 64 slots with 1 us resolution, O(1) arm and cancel
+class lv2_timer_wheel
 {
-	while (!Emu.IsStopped())
+	static const u32 levels = 6;
+
+	std::array<lv2_timer_node*, levels * 64> m_slots{};
+	std::array<u64, levels> m_mask{}; // Non-empty slots
+	u64 m_time = 0; // Processed up to (inclusive)
+
+	void link(lv2_timer_node& node)
 	{
-		const u32 _state = state;
+		// Select the level by the distance, nodes which are already due go to the next level 0 slot
+		const u64 delta = std::max<u64>(node.deadline, m_time + 1) - m_time;
+		const u32 level = std::min<u32>((63 - cntlz64(delta, true)) / 6, levels - 1);
+		const u64 when = std::max<u64>(node.deadline, m_time + 1) >> (level * 6);
 
-		if (_state == SYS_TIMER_STATE_RUN)
+		node.slot = level * 64 + (when % 64);
+		node.prev = nullptr;
+		node.next = m_slots[node.slot];
+
+		if (node.next)
 		{
-			const u64 _now = get_system_time();
-			const u64 next = expire;
+			node.next->prev = &node;
+		}
+
+		m_slots[node.slot] = &node;
+		m_mask[level] |= 1ull << (node.slot % 64);
+	}
+
+public:
+	bool empty() const
+	{
+		for (u64 mask : m_mask)
+		{
+			if (mask) return false;
+		}
 
-			if (_now >= next)
+		return true;
+	}
+
+	void arm(lv2_timer_node& node, u64 deadline)
+	{
+		cancel(node);
+
+		if (empty())
+		{
+			// Nothing to process, the current time may be set freely
+			m_time = std::max<u64>(m_time, get_system_time());
+		}
+
+		node.deadline = deadline;
+		link(node);
+	}
+
+	void cancel(lv2_timer_node& node)
+	{
+		if (node.slot == lv2_timer_node::unarmed)
+		{
+			return;
+		}
+
+		if (node.prev)
+		{
+			node.prev->next = node.next;
+		}
+		else if (!(m_slots[node.slot] = node.next))
+		{
+			m_mask[node.slot / 64] &= ~(1ull << (node.slot % 64));
+		}
+
+		if (node.next)
+		{
+			node.next->prev = node.prev;
+		}
+
+		node.slot = lv2_timer_node::unarmed;
+		node.prev = nullptr;
+		node.next = nullptr;
+	}
+
+	// Get the time of the next slot to process (-1 if empty)
+	u64 next() const
+	{
+		u64 result = -1;
+
+		for (u32 level = 0; level < levels; level++)
+		{
+			if (const u64 mask = m_mask[level])
 			{
-				semaphore_lock lock(mutex);
+				// Find the first non-empty slot after the current one
+				const u64 cur = m_time >> (level * 6);
+				const u32 shift = (cur + 1) % 64;
+				const u64 rot = shift ? (mask >> shift | mask << (64 - shift)) : mask;
+				result = std::min<u64>(result, (cur + 1 + cnttz64(rot, true)) << (level * 6));
+			}
+		}
+
+		return result;
+	}
 
-				if (const auto queue = port.lock())
+	// Process all slots up to the specified time, func is called for every expired (disarmed) node
+	template <typename F>
+	void advance(u64 time, F&& func)
+	{
+		for (u64 next = this->next(); next <= time; next = this->next())
+		{
+			m_time = next;
+
+			// Cascade from the highest level, nodes never move to the slot being processed
+			for (u32 level = levels; level--;)
+			{
+				if (m_time & ((1ull << (level * 6)) - 1))
+				{
+					continue;
+				}
+
+				const u32 slot = level * 64 + (m_time >> (level * 6)) % 64;
+
+				lv2_timer_node* list = m_slots[slot];
+
+				if (!list)
+				{
+					continue;
+				}
+
+				m_slots[slot] = nullptr;
+				m_mask[level] &= ~(1ull << (slot % 64));
+
+				while (lv2_timer_node* node = list)
 				{
-					queue->send(source, data1, data2, next);
+					list = node->next;
+					node->slot = lv2_timer_node::unarmed;
+					node->prev = nullptr;
+					node->next = nullptr;
 
-					if (period)
+					if (node->deadline <= m_time)
+					{
+						func(*node);
+					}
+					else
 					{
-						// Set next expiration time and check again (HACK)
-						expire += period;
-						continue;
+						link(*node);
 					}
 				}
+			}
+		}
 
-				// Stop: oneshot or the event port was disconnected (TODO: is it correct?)
-				state = SYS_TIMER_STATE_STOP; 
-				continue;
+		m_time = std::max<u64>(m_time, time);
+	}
+
+	// Disarm all nodes
+	void clear()
+	{
+		for (lv2_timer_node*& list : m_slots)
+		{
+			while (lv2_timer_node* node = list)
+			{
+				list = node->next;
+				node->slot = lv2_timer_node::unarmed;
+				node->prev = nullptr;
+				node->next = nullptr;
 			}
+		}
+
+		m_mask = {};
+		m_time = 0;
+	}
+};
+
+// Single thread servicing guest timers and syscall timeouts
+struct lv2_timer_service
+{
+	semaphore<> mutex;
+	lv2_timer_wheel wheel;
+	std::unordered_map<named_thread*, lv2_timer_node> timeouts;
+	std::shared_ptr<thread_ctrl> thread;
+	bool running = false;
+	u64 wait_until = -1; // Planned wakeup of the service thread
+	atomic_t<u32> armed_timeouts{0};
+
+	// Arm the node and wake up the service thread if necessary (mutex must be locked)
+	void arm(lv2_timer_node& node, u64 deadline);
+
+	void task();
+};
+
+static lv2_timer_service s_timers;
+
+// Send timer event and rearm periodic timer
+static void lv2_timer_expire(u32 timer_id)
+{
+	const auto timer = idm::get<lv2_obj, lv2_timer>(timer_id);
+
+	if (!timer)
+	{
+		return;
+	}
+
+	semaphore_lock lock(timer->mutex);
+
+	if (timer->state != SYS_TIMER_STATE_RUN)
+	{
+		return;
+	}
 
-			// TODO: use single global dedicated thread for busy waiting, no timer threads
-			lv2_obj::sleep_timeout(*this, next - _now);
-			thread_ctrl::wait_for(next - _now);
+	{
+		semaphore_lock lock(s_timers.mutex);
+
+		if (timer->node.slot != lv2_timer_node::unarmed)
+		{
+			// Restarted
+			return;
+		}
+	}
+
+	const u64 next = timer->expire;
+
+	if (const auto queue = timer->port.lock())
+	{
+		queue->send(timer->source, timer->data1, timer->data2, next);
+
+		if (const u64 period = timer->period)
+		{
+			// Set next expiration time (fires immediately again if it's already due)
+			timer->expire += period;
+
+			semaphore_lock lock2(s_timers.mutex);
+			s_timers.arm(timer->node, next + period);
+			return;
+		}
+	}
+
+	// Stop: oneshot or the event port was disconnected (TODO: is it correct?)
+	timer->state = SYS_TIMER_STATE_STOP;
+}
+
+void lv2_timer_service::arm(lv2_timer_node& node, u64 deadline)
+{
+	wheel.arm(node, deadline);
+
+	if (!running)
+	{
+		running = true;
+
+		thread_ctrl::spawn(thread, "lv2 Timer Thread", []
+		{
+			s_timers.task();
+		});
+	}
+	else if (deadline < wait_until)
+	{
+		thread->notify();
+	}
+}
+
+void lv2_timer_service::task()
+{
+	std::vector<u32> expired;
+
+	while (!Emu.IsStopped())
+	{
+		{
+			const u64 now = get_system_time();
+
+			semaphore_lock lock(mutex);
+
+			wheel.advance(now, [&](lv2_timer_node& node)
+			{
+				if (node.thread)
+				{
+					node.thread->notify();
+					armed_timeouts--;
+					timeouts.erase(node.thread);
+				}
+				else
+				{
+					expired.push_back(node.timer_id);
+				}
+			});
+
+			// Wait at most 10ms in order to notice emulation stop
+			wait_until = expired.empty() ? std::min<u64>(wheel.next(), now + 10000) : 0;
+		}
+
+		if (!expired.empty())
+		{
+			// Send events without the service lock
+			for (u32 id : expired)
+			{
+				lv2_timer_expire(id);
+			}
+
+			expired.clear();
+			continue;
 		}
-		else if (_state == SYS_TIMER_STATE_STOP)
+
+		const u64 now = get_system_time();
+
+		if (wait_until <= now)
 		{
-			thread_ctrl::wait_for(10000);
+			continue;
 		}
-		else
+
+		if (wait_until - now < 50)
 		{
-			break;
+			// Don't sleep for too short deadlines
+			std::this_thread::yield();
+			continue;
 		}
+
+		thread_ctrl::wait_for(wait_until - now);
+	}
+
+	semaphore_lock lock(mutex);
+	running = false;
+	wait_until = -1;
+}
+
+void lv2_timeout_arm(named_thread& thread, u64 wait_until)
+{
+	semaphore_lock lock(s_timers.mutex);
+
+	auto& node = s_timers.timeouts[&thread];
+
+	if (!node.thread)
+	{
+		node.thread = &thread;
+		s_timers.armed_timeouts++;
+	}
+
+	s_timers.arm(node, wait_until);
+}
+
+void lv2_timeout_cancel(named_thread& thread)
+{
+	if (!s_timers.armed_timeouts)
+	{
+		return;
+	}
+
+	semaphore_lock lock(s_timers.mutex);
+
+	const auto found = s_timers.timeouts.find(&thread);
+
+	if (found != s_timers.timeouts.end())
+	{
+		s_timers.wheel.cancel(found->second);
+		s_timers.timeouts.erase(found);
+		s_timers.armed_timeouts--;
 	}
 }
 
-void lv2_timer::on_stop()
+void lv2_timeout_cleanup()
+{
+	semaphore_lock lock(s_timers.mutex);
+
+	s_timers.wheel.clear();
+	s_timers.timeouts.clear();
+	s_timers.armed_timeouts = 0;
+
+	// The service thread has already exited (all threads are stopped), next arm() must spawn a new one
+	s_timers.thread.reset();
+	s_timers.running = false;
+	s_timers.wait_until = -1;
+}
+
+lv2_timer::lv2_timer()
+{
+	node.timer_id = idm::last_id();
+}
+
+lv2_timer::~lv2_timer()
 {
-	// Signal thread using invalid state
-	state = -1;
-	notify();
-	join();
+	semaphore_lock lock(s_timers.mutex);
+
+	s_timers.wheel.cancel(node);
 }
 
 error_code sys_timer_create(vm::ptr<u32> timer_id)
@@ -171,7 +495,9 @@ error_code _sys_timer_start(u32 timer_id, u64 base_time, u64 period)
 		timer.expire = base_time ? base_time : start_time + period;
 		timer.period = period;
 		timer.state  = SYS_TIMER_STATE_RUN;
-		timer.notify();
+
+		semaphore_lock lock2(s_timers.mutex);
+		s_timers.arm(timer.node, timer.expire);
 		return {};
 	});
 
@@ -197,6 +523,9 @@ error_code sys_timer_stop(u32 timer_id)
 		semaphore_lock lock(timer.mutex);
 
 		timer.state = SYS_TIMER_STATE_STOP;
+
+		semaphore_lock lock2(s_timers.mutex);
+		s_timers.wheel.cancel(timer.node);
 	});
 
 	if (!timer)
@@ -263,6 +592,9 @@ error_code sys_timer_disconnect_event_queue(u32 timer_id)
 
 		timer.state = SYS_TIMER_STATE_STOP;
 		timer.port.reset();
+
+		semaphore_lock lock2(s_timers.mutex);
+		s_timers.wheel.cancel(timer.node);
 		return {};
 	});
 
@@ -300,7 +632,7 @@ error_code sys_timer_usleep(ppu_thread& ppu, u64 sleep_time)
 
 	while (sleep_time >= passed)
 	{
-		thread_ctrl::wait_for(std::max<u64>(1, sleep_time - passed));
+		ppu.cpu_wait(std::max<u64>(1, sleep_time - passed));
 		passed = get_system_time() - ppu.start_time;
 	}
 
@@ -17,12 +17,25 @@ struct sys_timer_information_t
 	be_t<u32> pad;
 };
 
-struct lv2_timer final : public lv2_obj, public named_thread
+// Timer wheel entry (guarded by the timer service mutex)
+struct lv2_timer_node
+{
+	u64 deadline = 0;
+	lv2_timer_node* prev = nullptr;
+	lv2_timer_node* next = nullptr;
+	static const u32 unarmed = ~0u;
+
+	u32 slot = unarmed; // Wheel slot index
+	u32 timer_id = 0; // lv2_timer to fire
+	named_thread* thread = nullptr; // Or the thread to notify (syscall timeout)
+};
+
+struct lv2_timer final : public lv2_obj
 {
 	static const u32 id_base = 0x11000000;
 
-	void on_task() override;
-	void on_stop() override;
+	lv2_timer();
+	~lv2_timer();
 
 	semaphore<> mutex;
 	atomic_t<u32> state{SYS_TIMER_STATE_STOP};
@@ -34,8 +47,19 @@ struct lv2_timer final : public lv2_obj, public named_thread
 	
 	atomic_t<u64> expire{0}; // Next expiration time
 	atomic_t<u64> period{0}; // Period (oneshot if 0)
+
+	lv2_timer_node node;
 };
 
+// Register syscall timeout (the thread is notified at the specified time)
+void lv2_timeout_arm(named_thread&, u64 wait_until);
+
+// Unregister syscall timeout
+void lv2_timeout_cancel(named_thread&);
+
+// Reset timer service state (all threads must be stopped)
+void lv2_timeout_cleanup();
+
 class ppu_thread;
 
 // Syscalls
@@ -1,10 +1,13 @@
 #include "stdafx.h"
 #include "IdManager.h"
 
+#include <thread>
+
 shared_mutex id_manager::g_mutex;
 
 thread_local DECLARE(idm::g_id);
 DECLARE(idm::g_map);
+DECLARE(idm::g_table);
 DECLARE(fxm::g_vec);
 
 id_manager::id_map::pointer idm::allocate_id(const id_manager::id_key& info, u32 base, u32 step, u32 count)
@@ -12,8 +15,23 @@ id_manager::id_map::pointer idm::allocate_id(const id_manager::id_key& info, u32
 	// Base type id is stored in value
 	auto& vec = g_map[info.value()];
 
-	// Preallocate memory
-	vec.reserve(count);
+	if (const auto table = g_table[info.value()].load())
+	{
+		// Storage can't grow anymore (types sharing the map must have the same id_count)
+		verify("idm::allocate_id" HERE), count == table->count;
+	}
+	else
+	{
+		// Preallocate memory
+		vec.reserve(count);
+
+		// Create lock-free lookup table (intentionally never freed)
+		const auto _new = new id_manager::id_table;
+		_new->data = vec.data();
+		_new->count = count;
+		_new->state = std::make_unique<atomic_t<u32>[]>(count);
+		g_table[info.value()] = _new;
+	}
 
 	if (vec.size() < count)
 	{
@@ -46,10 +64,33 @@ id_manager::id_map::pointer idm::allocate_id(const id_manager::id_key& info, u32
 	return nullptr;
 }
 
+void idm::publish_id(u32 type, id_manager::id_map::pointer ptr)
+{
+	const auto table = g_table[type].load();
+
+	table->state[ptr - table->data] |= id_manager::id_table::alive;
+}
+
+void idm::unpublish_id(u32 type, id_manager::id_map::pointer ptr)
+{
+	const auto table = g_table[type].load();
+
+	auto& state = table->state[ptr - table->data];
+
+	state &= ~id_manager::id_table::alive;
+
+	// Wait for the readers which could have seen the object
+	while (state)
+	{
+		std::this_thread::yield();
+	}
+}
+
 void idm::init()
 {
 	// Allocate
 	g_map.resize(id_manager::typeinfo::get_count());
+	g_table = std::make_unique<atomic_t<id_manager::id_table*>[]>(id_manager::typeinfo::get_count());
 	idm::clear();
 }
 
@@ -58,6 +99,22 @@ void idm::clear()
 	// Call recorded finalization functions for all IDs
 	for (auto& map : g_map)
 	{
+		if (const auto table = g_table[&map - g_map.data()].load())
+		{
+			// Hide everything from lock-free readers, wait for the readers which could have seen the objects (as unpublish_id does)
+			for (u32 i = 0; i < table->count; i++)
+			{
+				auto& state = table->state[i];
+
+				state &= ~id_manager::id_table::alive;
+
+				while (state)
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
 		for (auto& pair : map)
 		{
 			if (auto ptr = pair.second.get())
@@ -172,6 +172,22 @@ namespace id_manager
 	};
 
 	using id_map = std::vector<std::pair<id_key, std::shared_ptr<void>>>;
+
+	// Lock-free view of id_map storage (created once the storage is reserved, never moved or freed)
+	struct id_table
+	{
+		// Alive flag in the slot state (other bits: number of lock-free readers)
+		static const u32 alive = 0x80000000;
+
+		// Stable id_map storage
+		id_map::pointer data;
+
+		// Storage capacity
+		u32 count;
+
+		// Slot states
+		std::unique_ptr<atomic_t<u32>[]> state;
+	};
 }
 
 // Object manager for emulated process. Multiple objects of specified arbitrary type are given unique IDs.
@@ -183,6 +199,9 @@ class idm
 	// Type Index -> ID -> Object. Use global since only one process is supported atm.
 	static std::vector<id_manager::id_map> g_map;
 
+	// Type Index -> Lock-free lookup table
+	static std::unique_ptr<atomic_t<id_manager::id_table*>[]> g_table;
+
 	template <typename T>
 	static inline u32 get_type()
 	{
@@ -294,6 +313,47 @@ class idm
 		return nullptr;
 	}
 
+	// Find ID without locking, call func(ptr) while the ID is protected from removal (returns false if not found)
+	template <typename T, typename Type, typename F>
+	static bool find_id_lockfree(u32 id, F&& func)
+	{
+		static_assert(id_manager::id_verify<T, Type>::value, "Invalid ID type combination");
+
+		const u32 index = get_index<Type>(id);
+
+		const auto table = g_table[get_type<T>()].load();
+
+		if (!table || index >= table->count || index >= id_manager::id_traits<Type>::count)
+		{
+			return false;
+		}
+
+		auto& state = table->state[index];
+
+		bool result = false;
+
+		// Register as reader: the slot is only changed after all readers are gone
+		if (state.fetch_add(1) & id_manager::id_table::alive)
+		{
+			const auto& data = table->data[index];
+
+			if (std::is_same<T, Type>::value || data.first.type() == get_type<Type>())
+			{
+				func(data.second);
+				result = true;
+			}
+		}
+
+		state--;
+		return result;
+	}
+
+	// Make the ID visible to lock-free readers (writer lock must be held)
+	static void publish_id(u32 type, id_manager::id_map::pointer ptr);
+
+	// Hide the ID from lock-free readers and wait for them (writer lock must be held)
+	static void unpublish_id(u32 type, id_manager::id_map::pointer ptr);
+
 	// Allocate new ID and assign the object from the provider()
 	template <typename T, typename Type, typename F>
 	static id_manager::id_map::pointer create_id(F&& provider)
@@ -316,6 +376,7 @@ class idm
 
 			if (place->second)
 			{
+				publish_id(get_type<T>(), place);
 				return place;
 			}
 		}
@@ -407,13 +468,23 @@ public:
 		return nullptr;
 	}
 
-	// Check the ID
+	// Check the ID (lock-free)
 	template <typename T, typename Get = T>
 	static inline Get* check(u32 id)
 	{
-		reader_lock lock(id_manager::g_mutex);
+		Get* result = nullptr;
+
+		if (!find_id_lockfree<T, Get>(id, [&](const std::shared_ptr<void>& ptr)
+		{
+			result = static_cast<Get*>(ptr.get());
+		}))
+		{
+			// The ID may be hidden temporarily by withdraw()
+			reader_lock lock(id_manager::g_mutex);
+			result = check_unlocked<T, Get>(id);
+		}
 
-		return check_unlocked<T, Get>(id);
+		return result;
 	}
 
 	// Check the ID, access object under shared lock
@@ -445,6 +516,25 @@ public:
 		return {nullptr};
 	}
 
+	// Check the ID without locking, access object while it can't be withdrawn, propagate return value (func must be short)
+	template <typename T, typename Get = T, typename F, typename FRT = std::result_of_t<F(Get&)>, typename = std::enable_if_t<!std::is_void<FRT>::value>>
+	static inline return_pair<Get*, FRT> check_lockfree(u32 id, F&& func)
+	{
+		return_pair<Get*, FRT> result{nullptr};
+
+		if (find_id_lockfree<T, Get>(id, [&](const std::shared_ptr<void>& ptr)
+		{
+			const auto _ptr = static_cast<Get*>(ptr.get());
+			result = {_ptr, func(*_ptr)};
+		}))
+		{
+			return result;
+		}
+
+		// The ID may be hidden temporarily by withdraw()
+		return check<T, Get>(id, std::forward<F>(func));
+	}
+
 	// Get the object without locking (can be called from other method)
 	template <typename T, typename Get = T>
 	static inline std::shared_ptr<Get> get_unlocked(u32 id)
@@ -459,20 +549,23 @@ public:
 		return {found->second, static_cast<Get*>(found->second.get())};
 	}
 
-	// Get the object
+	// Get the object (lock-free)
 	template <typename T, typename Get = T>
 	static inline std::shared_ptr<Get> get(u32 id)
 	{
-		reader_lock lock(id_manager::g_mutex);
+		std::shared_ptr<Get> result;
 
-		const auto found = find_id<T, Get>(id);
-
-		if (UNLIKELY(found == nullptr))
+		if (!find_id_lockfree<T, Get>(id, [&](const std::shared_ptr<void>& ptr)
 		{
-			return nullptr;
+			result = {ptr, static_cast<Get*>(ptr.get())};
+		}))
+		{
+			// The ID may be hidden temporarily by withdraw()
+			reader_lock lock(id_manager::g_mutex);
+			result = get_unlocked<T, Get>(id);
 		}
 
-		return {found->second, static_cast<Get*>(found->second.get())};
+		return result;
 	}
 
 	// Get the object, access object under reader lock
@@ -580,6 +673,7 @@ public:
 
 			if (const auto found = find_id<T, Get>(id))
 			{
+				unpublish_id(get_type<T>(), found);
 				ptr = std::move(found->second);
 			}
 			else
@@ -602,6 +696,7 @@ public:
 
 			if (const auto found = find_id<T, Get>(id))
 			{
+				unpublish_id(get_type<T>(), found);
 				ptr = std::move(found->second);
 			}
 			else
@@ -626,8 +721,10 @@ public:
 
 			if (const auto found = find_id<T, Get>(id))
 			{
-				func(*static_cast<Get*>(found->second.get()));
+				// Lock-free readers must be gone before the object is accessed
+				unpublish_id(get_type<T>(), found);
 
+				func(*static_cast<Get*>(found->second.get()));
 				ptr = std::move(found->second);
 			}
 			else
@@ -655,10 +752,14 @@ public:
 			{
 				const auto _ptr = static_cast<Get*>(found->second.get());
 
+				// Lock-free readers must be gone before the object is accessed, they fall back to locking meanwhile
+				unpublish_id(get_type<T>(), found);
+
 				ret = func(*_ptr);
 
 				if (ret)
 				{
+					publish_id(get_type<T>(), found);
 					return result_type{{found->second, _ptr}, std::move(ret)};
 				}
 
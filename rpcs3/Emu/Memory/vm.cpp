@@ -10,6 +10,7 @@
 
 #include <atomic>
 #include <deque>
+#include <zlib.h>
 
 namespace vm
 {
@@ -39,11 +40,31 @@ namespace vm
 	// Memory locations
 	std::vector<std::shared_ptr<block_t>> g_locations;
 
+	// Set if the host refused huge page advice
+	static bool g_huge_pages_failed = false;
+
 	// Reservations (lock lines) in a single memory page
 	using reservation_info = std::array<std::atomic<u64>, 4096 / 128>;
 
-	// Registered waiters
-	std::deque<vm::waiter*> g_waiters;
+	// Registered waiters for a set of 128-byte lines
+	struct alignas(64) waiter_bucket
+	{
+		shared_mutex mutex;
+		std::vector<const vm::waiter*> list;
+		atomic_t<u32> count{0}; // List size, read without locking
+		atomic_t<u64> wakeups{0};
+	};
+
+	// Registered waiters (hashed by line address)
+	std::array<waiter_bucket, 64> g_waiters;
+
+	// Waiters woken up without the awaited change
+	atomic_t<u64> g_waiter_spurious{0};
+
+	static waiter_bucket& _waiter_bucket(u32 line)
+	{
+		return g_waiters[(line * 0x9e3779b1u) >> 26];
+	}
 
 	// Memory mutex core
 	shared_mutex g_mutex;
@@ -51,16 +72,35 @@ namespace vm
 	// Memory mutex acknowledgement
 	thread_local atomic_t<cpu_thread*>* g_tls_locked = nullptr;
 
+	// Passive lock slot (cache line isolated to avoid false sharing between readers)
+	struct alignas(64) passive_slot
+	{
+		atomic_t<cpu_thread*> cpu;
+	};
+
 	// Memory mutex: passive locks
-	std::array<atomic_t<cpu_thread*>, 32> g_locks;
+	std::array<passive_slot, 64> g_locks{};
+
+	// Passive lock epoch (odd while a full writer lock is being acquired or held)
+	atomic_t<u64> g_epoch{0};
+
+	// Writer stall statistics
+	atomic_t<u64> g_stall_count{0};
+	atomic_t<u64> g_stall_total{0};
+	atomic_t<u64> g_stall_max{0};
+	atomic_t<u64> g_stall_waited{0};
 
 	static void _register_lock(cpu_thread* _cpu)
 	{
-		for (u32 i = 0;; i = (i + 1) % g_locks.size())
+		// Start from the slot used last time by this thread, it's likely free and not shared
+		thread_local u32 hint = 0;
+
+		for (u32 i = hint;; i = (i + 1) % g_locks.size())
 		{
-			if (!g_locks[i] && g_locks[i].compare_and_swap_test(nullptr, _cpu))
+			if (!g_locks[i].cpu && g_locks[i].cpu.compare_and_swap_test(nullptr, _cpu))
 			{
-				g_tls_locked = g_locks.data() + i;
+				g_tls_locked = &g_locks[i].cpu;
+				hint = i;
 				return;
 			}
 		}
@@ -73,6 +113,18 @@ namespace vm
 			return;
 		}
 
+		// Fast path: publish the slot, then check that no full writer has started
+		_register_lock(&cpu);
+
+		if (LIKELY(!(g_epoch & 1)))
+		{
+			return;
+		}
+
+		// Straggler: back off and wait for the writer
+		g_tls_locked->compare_and_swap_test(&cpu, nullptr);
+		g_tls_locked = nullptr;
+
 		::reader_lock lock(g_mutex);
 
 		_register_lock(&cpu);
@@ -97,9 +149,9 @@ namespace vm
 
 		for (u32 i = 0; i < g_locks.size(); i++)
 		{
-			if (g_locks[i] == &cpu)
+			if (g_locks[i].cpu == &cpu)
 			{
-				g_locks[i].compare_and_swap_test(&cpu, nullptr);
+				g_locks[i].cpu.compare_and_swap_test(&cpu, nullptr);
 				return;
 			}
 		}
@@ -167,25 +219,43 @@ namespace vm
 
 		if (full)
 		{
+			// Start new epoch: passive readers registering from now on will back off
+			g_epoch++;
+
+			u64 waited = 0;
+
 			for (auto& lock : g_locks)
 			{
-				if (cpu_thread* ptr = lock)
+				if (cpu_thread* ptr = lock.cpu)
 				{
 					ptr->state.test_and_set(cpu_flag::memory);
+					waited++;
 				}
 			}
 
-			for (auto& lock : g_locks)
+			if (waited)
 			{
-				while (cpu_thread* ptr = lock)
+				const auto start = std::chrono::steady_clock::now();
+
+				for (auto& lock : g_locks)
 				{
-					if (test(ptr->state, cpu_flag::dbg_global_stop + cpu_flag::exit))
+					while (cpu_thread* ptr = lock.cpu)
 					{
-						break;
-					}
+						if (test(ptr->state, cpu_flag::dbg_global_stop + cpu_flag::exit))
+						{
+							break;
+						}
 
-					busy_wait();
+						busy_wait();
+					}
 				}
+
+				const u64 stall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+				g_stall_count++;
+				g_stall_total += stall;
+				g_stall_waited += waited;
+				g_stall_max.atomic_op([&](u64& max) { max = std::max(max, stall); });
 			}
 		}
 
@@ -205,16 +275,35 @@ namespace vm
 	{
 		if (locked)
 		{
+			// End epoch if it was started by this (full) writer
+			if (g_epoch & 1)
+			{
+				g_epoch++;
+			}
+
 			g_mutex.unlock();
 		}
 	}
 
+	lock_stats get_lock_stats()
+	{
+		lock_stats result;
+		result.stalls = g_stall_count;
+		result.stall_ns = g_stall_total;
+		result.max_stall_ns = g_stall_max;
+		result.stragglers = g_stall_waited;
+		return result;
+	}
+
 	// Page information
 	struct memory_page
 	{
 		// Memory flags
 		atomic_t<u8> flags;
 
+		// Host protection requested by host_protect() (utils::protection)
+		atomic_t<u8> watch;
+
 		atomic_t<u32> waiters;
 
 		// Reservations
@@ -258,67 +347,232 @@ namespace vm
 
 	void waiter::init()
 	{
-		// Register waiter
-		writer_lock lock(0);
+		// Register waiter in the buckets of all lines it covers
+		for (u32 line = addr / 128; line <= (addr + size - 1) / 128; line++)
+		{
+			auto& bucket = _waiter_bucket(line);
+
+			::writer_lock lock(bucket.mutex);
 
-		g_waiters.emplace_back(this);
+			bucket.list.emplace_back(this);
+			bucket.count = ::size32(bucket.list);
+		}
+
+		linked = true;
 	}
 
-	void waiter::test() const
+	bool waiter::test() const
 	{
 		if (std::memcmp(data, vm::base(addr), size) == 0)
 		{
-			return;
+			return false;
 		}
 
 		memory_page& page = g_pages[addr >> 12];
 
 		if (page.reservations == nullptr)
 		{
-			return;
+			return false;
 		}
 
 		if (stamp >= (*page.reservations)[(addr & 0xfff) >> 7].load())
 		{
-			return;
+			return false;
 		}
 
 		if (owner)
 		{
 			owner->notify();
+			return true;
 		}
+
+		return false;
+	}
+
+	void waiter::count_spurious()
+	{
+		g_waiter_spurious++;
 	}
 
 	waiter::~waiter()
 	{
+		if (!linked)
+		{
+			return;
+		}
+
 		// Unregister waiter
-		writer_lock lock(0);
+		for (u32 line = addr / 128; line <= (addr + size - 1) / 128; line++)
+		{
+			auto& bucket = _waiter_bucket(line);
 
-		// Find waiter
-		const auto found = std::find(g_waiters.cbegin(), g_waiters.cend(), this);
+			::writer_lock lock(bucket.mutex);
 
-		if (found != g_waiters.cend())
-		{
-			g_waiters.erase(found);
+			bucket.list.erase(std::remove(bucket.list.begin(), bucket.list.end(), this), bucket.list.end());
+			bucket.count = ::size32(bucket.list);
 		}
 	}
 
 	void notify(u32 addr, u32 size)
 	{
-		for (const waiter* ptr : g_waiters)
+		for (u32 line = addr / 128; line <= (addr + size - 1) / 128; line++)
 		{
-			if (ptr->addr / 128 == addr / 128)
+			auto& bucket = _waiter_bucket(line);
+
+			// Don't touch the lock of an empty bucket (notify is called inside transactions)
+			if (!bucket.count)
+			{
+				continue;
+			}
+
+			::reader_lock lock(bucket.mutex);
+
+			for (const waiter* ptr : bucket.list)
 			{
-				ptr->test();
+				// Only test waiters overlapping the written range
+				if (ptr->addr < addr + size && addr < ptr->addr + ptr->size && ptr->test())
+				{
+					bucket.wakeups++;
+				}
 			}
 		}
 	}
 
 	void notify_all()
 	{
-		for (const waiter* ptr : g_waiters)
+		for (auto& bucket : g_waiters)
+		{
+			::reader_lock lock(bucket.mutex);
+
+			for (const waiter* ptr : bucket.list)
+			{
+				if (ptr->test())
+				{
+					bucket.wakeups++;
+				}
+			}
+		}
+	}
+
+	waiter_stats get_waiter_stats()
+	{
+		waiter_stats result;
+
+		for (auto& bucket : g_waiters)
+		{
+			result.wakeups += bucket.wakeups;
+		}
+
+		result.spurious = g_waiter_spurious;
+		return result;
+	}
+
+	// Dirty page tracking range
+	struct dirty_range
+	{
+		u32 size;
+
+		// Per page: epoch of the last re-arm, or unarmed (host page writable, assume dirty)
+		std::unique_ptr<atomic_t<u64>[]> pages;
+	};
+
+	static const u64 s_dirty_unarmed = -1;
+
+	// Dirty page tracking ranges: addr -> range
+	std::map<u32, dirty_range> g_dirty_ranges;
+
+	// Number of dirty page tracking ranges (checked without the mutex)
+	atomic_t<u32> g_dirty_count{0};
+
+	// Dirty page tracking mutex (exclusive for re-arming, shared for faults)
+	shared_mutex g_dirty_mutex;
+
+	// Dirty page tracking epoch
+	atomic_t<u64> g_dirty_epoch{1};
+
+	// Host protection mutex for tracked pages (faults and host_protect() calls would race otherwise)
+	shared_mutex g_dirty_prot_mutex;
+
+	// Number of dirty_host_write objects alive (pages aren't re-armed meanwhile)
+	atomic_t<u32> g_dirty_host_writes{0};
+
+	// Find tracking stamp of the page (g_dirty_mutex must be locked)
+	static atomic_t<u64>* _dirty_find(u32 addr)
+	{
+		auto found = g_dirty_ranges.upper_bound(addr);
+
+		if (found == g_dirty_ranges.begin() || u64{(--found)->first} + found->second.size <= addr)
+		{
+			return nullptr;
+		}
+
+		return &found->second.pages[(addr - found->first) / 4096];
+	}
+
+	// Apply host protection: watch protection has priority, armed tracked pages are read-only, otherwise rw.
+	// Pages without page_writable are skipped unless "all" is set (g_dirty_mutex and g_dirty_prot_mutex must be locked).
+	static void _dirty_protect(u32 addr, u32 size, bool all = false)
+	{
+		auto get = [&](u32 page) -> int
+		{
+			const bool writable = (g_pages[page].flags & (page_allocated | page_writable)) == (page_allocated | page_writable);
+
+			if (!writable && !all)
+			{
+				return -1;
+			}
+
+			const auto watch = static_cast<utils::protection>(g_pages[page].watch.load());
+
+			if (watch != utils::protection::rw)
+			{
+				return static_cast<int>(watch);
+			}
+
+			const auto stamp = writable ? _dirty_find(page * 4096) : nullptr;
+			return static_cast<int>(stamp && *stamp != s_dirty_unarmed ? utils::protection::ro : utils::protection::rw);
+		};
+
+		const u32 end = addr / 4096 + size / 4096;
+
+		int prot = get(addr / 4096);
+
+		for (u32 start = addr / 4096, i = start; i < end; start = i)
+		{
+			int next = prot;
+
+			while (++i < end && (next = get(i)) == prot)
+			{
+			}
+
+			if (prot >= 0)
+			{
+				utils::memory_protect(g_base_addr + start * 4096, (i - start) * 4096, static_cast<utils::protection>(prot));
+			}
+
+			prot = next;
+		}
+	}
+
+	// Mark tracked pages in range as dirty (their host protection was reset)
+	static void _dirty_unarm(u32 addr, u32 size)
+	{
+		if (!g_dirty_count)
+		{
+			return;
+		}
+
+		::reader_lock lock(g_dirty_mutex);
+
+		for (auto& pair : g_dirty_ranges)
 		{
-			ptr->test();
+			const u32 start = std::max(addr, pair.first);
+			const u64 end = std::min<u64>(u64{addr} + size, u64{pair.first} + pair.second.size);
+
+			for (u64 i = start; i < end; i += 4096)
+			{
+				pair.second.pages[(i - pair.first) / 4096] = s_dirty_unarmed;
+			}
 		}
 	}
 
@@ -349,6 +603,20 @@ namespace vm
 			utils::memory_commit(g_stat_addr + addr, size);
 		}
 
+		// Large allocations and 1M-paged areas are likely to cover whole 2 MiB host pages
+		if (g_cfg.core.huge_pages && !g_huge_pages_failed && (flags & page_1m_size || size >= 0x200000))
+		{
+			if (!utils::memory_advise_huge(g_base_addr + addr, size))
+			{
+				LOG_ERROR(MEMORY, "Huge pages are not available, falling back to regular pages");
+				g_huge_pages_failed = true;
+			}
+			else if (flags & page_executable)
+			{
+				utils::memory_advise_huge(g_exec_addr + addr, size);
+			}
+		}
+
 		for (u32 i = addr / 4096; i < addr / 4096 + size / 4096; i++)
 		{
 			if (g_pages[i].flags.exchange(flags | page_allocated))
@@ -356,6 +624,8 @@ namespace vm
 				fmt::throw_exception("Concurrent access (addr=0x%x, size=0x%x, flags=0x%x, current_addr=0x%x)" HERE, addr, size, flags, i * 4096);
 			}
 		}
+
+		_dirty_unarm(addr, size);
 	}
 
 	bool page_protect(u32 addr, u32 size, u8 flags_test, u8 flags_set, u8 flags_clear)
@@ -413,6 +683,11 @@ namespace vm
 			}
 		}
 
+		if (flags_set & page_writable)
+		{
+			_dirty_unarm(addr, size);
+		}
+
 		return true;
 	}
 
@@ -437,6 +712,9 @@ namespace vm
 			{
 				fmt::throw_exception("Concurrent access (addr=0x%x, size=0x%x, current_addr=0x%x)" HERE, addr, size, i * 4096);
 			}
+
+			// Fresh mapping starts without watch protection
+			g_pages[i].watch = 0;
 		}
 
 		utils::memory_decommit(g_base_addr + addr, size);
@@ -461,117 +739,383 @@ namespace vm
 		return true;
 	}
 
-	u32 alloc(u32 size, memory_location_t location, u32 align, u32 sup)
+	bool dirty_track(u32 addr, u32 size)
 	{
-		const auto block = get(location);
-
-		if (!block)
+		if (!size || (size | addr) % 4096)
 		{
-			fmt::throw_exception("Invalid memory location (%u)" HERE, (uint)location);
+			fmt::throw_exception("Invalid arguments (addr=0x%x, size=0x%x)" HERE, addr, size);
 		}
 
-		return block->alloc(size, align, nullptr, sup);
-	}
+		::writer_lock lock(g_dirty_mutex);
 
-	u32 falloc(u32 addr, u32 size, memory_location_t location, u32 sup)
-	{
-		const auto block = get(location, addr);
+		// Check overlapping with existing ranges
+		const auto next = g_dirty_ranges.lower_bound(addr);
 
-		if (!block)
+		if (next != g_dirty_ranges.end() && next->first < u64{addr} + size)
 		{
-			fmt::throw_exception("Invalid memory location (%u, addr=0x%x)" HERE, (uint)location, addr);
+			return false;
 		}
 
-		return block->falloc(addr, size, nullptr, sup);
-	}
+		if (next != g_dirty_ranges.begin() && u64{std::prev(next)->first} + std::prev(next)->second.size > addr)
+		{
+			return false;
+		}
 
-	u32 dealloc(u32 addr, memory_location_t location, u32* sup_out)
-	{
-		const auto block = get(location, addr);
+		auto& range = g_dirty_ranges[addr];
+		range.size = size;
+		range.pages.reset(new atomic_t<u64>[size / 4096]);
 
-		if (!block)
+		// Initially all pages are dirty, the first dirty_collect() call arms them
+		for (u32 i = 0; i < size / 4096; i++)
 		{
-			fmt::throw_exception("Invalid memory location (%u, addr=0x%x)" HERE, (uint)location, addr);
+			range.pages[i] = s_dirty_unarmed;
 		}
 
-		return block->dealloc(addr, nullptr, sup_out);
+		g_dirty_count++;
+		return true;
 	}
 
-	void dealloc_verbose_nothrow(u32 addr, memory_location_t location) noexcept
+	void dirty_untrack(u32 addr)
 	{
-		const auto block = get(location, addr);
+		::writer_lock lock(g_dirty_mutex);
 
-		if (!block)
+		const auto found = g_dirty_ranges.find(addr);
+
+		if (found == g_dirty_ranges.end())
 		{
-			LOG_ERROR(MEMORY, "vm::dealloc(): invalid memory location (%u, addr=0x%x)\n", (uint)location, addr);
 			return;
 		}
 
-		if (!block->dealloc(addr))
+		// Restore host protection of armed pages (keep watch protection)
+		for (u32 i = 0; i < found->second.size / 4096; i++)
 		{
-			LOG_ERROR(MEMORY, "vm::dealloc(): deallocation failed (addr=0x%x)\n", addr);
-			return;
+			if (found->second.pages[i].exchange(s_dirty_unarmed) != s_dirty_unarmed)
+			{
+				_dirty_protect(addr + i * 4096, 4096);
+			}
 		}
+
+		g_dirty_ranges.erase(found);
+		g_dirty_count--;
 	}
 
-	bool block_t::try_alloc(u32 addr, u32 size, u8 flags, u32 sup)
+	u64 dirty_collect(u32 addr, u32 size, u64 since, std::vector<u32>& pages)
 	{
-		// Check if memory area is already mapped
-		for (u32 i = addr / 4096; i <= (addr + size - 1) / 4096; i++)
+		::writer_lock lock(g_dirty_mutex);
+
+		const u64 epoch = g_dirty_epoch++;
+
+		// Host OS may be writing to some pages right now, re-arming them would make it fail
+		const bool no_rearm = g_dirty_host_writes != 0;
+
+		for (auto& pair : g_dirty_ranges)
 		{
-			if (g_pages[i].flags)
+			const u32 start = std::max(addr, pair.first);
+			const u64 end = std::min<u64>(u64{addr} + size, u64{pair.first} + pair.second.size);
+
+			// Re-arm contiguous runs of dirty writable pages with a single protection change
+			u64 run = end;
+
+			for (u64 i = start; i < end + 4096; i += 4096)
 			{
-				return false;
+				const bool rearm = i < end && !no_rearm && pair.second.pages[(i - pair.first) / 4096] == s_dirty_unarmed &&
+					(g_pages[i / 4096].flags & (page_allocated | page_writable)) == (page_allocated | page_writable);
+
+				if (rearm && run == end)
+				{
+					run = i;
+				}
+				else if (!rearm && run != end)
+				{
+					// Pages protected by host_protect() keep their protection (still armed: the watcher unprotects them through host_protect())
+					_dirty_protect(static_cast<u32>(run), static_cast<u32>(i - run));
+					run = end;
+				}
+
+				if (i >= end)
+				{
+					break;
+				}
+
+				auto& stamp = pair.second.pages[(i - pair.first) / 4096];
+
+				if (stamp == s_dirty_unarmed || stamp > since)
+				{
+					pages.emplace_back(static_cast<u32>(i));
+				}
+
+				if (rearm)
+				{
+					stamp = epoch;
+				}
 			}
 		}
 
-		// Map "real" memory pages
-		_page_map(addr, size, flags);
+		return epoch;
+	}
 
-		// Add entry
-		m_map[addr] = size;
+	bool dirty_fault(u32 addr)
+	{
+		if (!g_dirty_count || (g_pages[addr / 4096].flags & (page_allocated | page_writable)) != (page_allocated | page_writable))
+		{
+			return false;
+		}
 
-		// Add supplementary info if necessary
-		if (sup) m_sup[addr] = sup;
+		::reader_lock lock(g_dirty_mutex);
 
-		return true;
+		const auto stamp = _dirty_find(addr);
+
+		if (!stamp)
+		{
+			return false;
+		}
+
+		::writer_lock plock(g_dirty_prot_mutex);
+
+		// Unprotect the whole page: further writes in this epoch don't fault (unless it's still watched)
+		*stamp = s_dirty_unarmed;
+		_dirty_protect(addr & -4096, 4096);
+		return static_cast<utils::protection>(g_pages[addr / 4096].watch.load()) == utils::protection::rw;
 	}
 
-	block_t::block_t(u32 addr, u32 size, u64 flags)
-		: addr(addr)
-		, size(size)
-		, flags(flags)
+	dirty_host_write::dirty_host_write(u32 addr, u32 size)
 	{
+		g_dirty_host_writes++;
+		add(addr, size);
 	}
 
-	block_t::~block_t()
+	void dirty_host_write::add(u32 addr, u32 size)
 	{
-		writer_lock lock;
+		if (!size || !g_dirty_count)
+		{
+			return;
+		}
 
-		// Deallocate all memory
-		for (auto& entry : m_map)
+		::reader_lock lock(g_dirty_mutex);
+		::writer_lock plock(g_dirty_prot_mutex);
+
+		const u32 start = addr & -4096;
+		const u32 end = static_cast<u32>(std::min<u64>(::align<u64>(u64{addr} + size, 4096), 0x100000000) / 4096);
+
+		for (u32 i = start / 4096; i < end; i++)
 		{
-			_page_unmap(entry.first, entry.second);
+			const auto stamp = _dirty_find(i * 4096);
+
+			if (stamp && stamp->exchange(s_dirty_unarmed) != s_dirty_unarmed)
+			{
+				_dirty_protect(i * 4096, 4096);
+			}
 		}
 	}
 
-	u32 block_t::alloc(const u32 orig_size, u32 align, const uchar* data, u32 sup)
+	dirty_host_write::~dirty_host_write()
 	{
-		writer_lock lock;
-
-		// Align to minimal page size
-		const u32 size = ::align(orig_size, 4096);
+		g_dirty_host_writes--;
+	}
 
-		// Check alignment (it's page allocation, so passing small values there is just silly)
-		if (align < 4096 || align != (0x80000000u >> cntlz32(align, true)))
+	void host_protect(u32 addr, u32 size, utils::protection prot)
+	{
+		if (!size || (size | addr) % 4096)
 		{
-			fmt::throw_exception("Invalid alignment (size=0x%x, align=0x%x)" HERE, size, align);
+			fmt::throw_exception("Invalid arguments (addr=0x%x, size=0x%x)" HERE, addr, size);
 		}
 
-		// Return if size is invalid
-		if (!size || size > this->size)
+		::reader_lock lock(g_dirty_mutex);
+		::writer_lock plock(g_dirty_prot_mutex);
+
+		for (u32 i = addr / 4096; i < addr / 4096 + size / 4096; i++)
 		{
-			return 0;
+			g_pages[i].watch = static_cast<u8>(prot);
+		}
+
+		_dirty_protect(addr, size, true);
+	}
+
+	u32 alloc(u32 size, memory_location_t location, u32 align, u32 sup)
+	{
+		const auto block = get(location);
+
+		if (!block)
+		{
+			fmt::throw_exception("Invalid memory location (%u)" HERE, (uint)location);
+		}
+
+		return block->alloc(size, align, nullptr, sup);
+	}
+
+	u32 falloc(u32 addr, u32 size, memory_location_t location, u32 sup)
+	{
+		const auto block = get(location, addr);
+
+		if (!block)
+		{
+			fmt::throw_exception("Invalid memory location (%u, addr=0x%x)" HERE, (uint)location, addr);
+		}
+
+		return block->falloc(addr, size, nullptr, sup);
+	}
+
+	u32 dealloc(u32 addr, memory_location_t location, u32* sup_out)
+	{
+		const auto block = get(location, addr);
+
+		if (!block)
+		{
+			fmt::throw_exception("Invalid memory location (%u, addr=0x%x)" HERE, (uint)location, addr);
+		}
+
+		return block->dealloc(addr, nullptr, sup_out);
+	}
+
+	void dealloc_verbose_nothrow(u32 addr, memory_location_t location) noexcept
+	{
+		const auto block = get(location, addr);
+
+		if (!block)
+		{
+			LOG_ERROR(MEMORY, "vm::dealloc(): invalid memory location (%u, addr=0x%x)\n", (uint)location, addr);
+			return;
+		}
+
+		if (!block->dealloc(addr))
+		{
+			LOG_ERROR(MEMORY, "vm::dealloc(): deallocation failed (addr=0x%x)\n", addr);
+			return;
+		}
+	}
+
+	void block_t::free_insert(u32 addr, u32 size)
+	{
+		auto next = m_free.lower_bound(addr);
+
+		if (next != m_free.begin())
+		{
+			const auto prev = std::prev(next);
+
+			if (u64{prev->first} + prev->second == addr)
+			{
+				addr = prev->first;
+				size += prev->second;
+				m_free_by_size.erase({prev->second, prev->first});
+				m_free.erase(prev);
+			}
+		}
+
+		if (next != m_free.end() && u64{addr} + size == next->first)
+		{
+			size += next->second;
+			m_free_by_size.erase({next->second, next->first});
+			m_free.erase(next);
+		}
+
+		m_free.emplace(addr, size);
+		m_free_by_size.emplace(size, addr);
+	}
+
+	bool block_t::free_take(u32 addr, u32 size)
+	{
+		auto found = m_free.upper_bound(addr);
+
+		if (found == m_free.begin())
+		{
+			return false;
+		}
+
+		--found;
+
+		const u64 ext_addr = found->first;
+		const u64 ext_end = ext_addr + found->second;
+		const u64 end = u64{addr} + size;
+
+		if (end > ext_end)
+		{
+			return false;
+		}
+
+		m_free_by_size.erase({found->second, found->first});
+		m_free.erase(found);
+
+		// Keep the remaining parts (they can't be adjacent to other free extents)
+		if (addr > ext_addr)
+		{
+			m_free.emplace(static_cast<u32>(ext_addr), static_cast<u32>(addr - ext_addr));
+			m_free_by_size.emplace(static_cast<u32>(addr - ext_addr), static_cast<u32>(ext_addr));
+		}
+
+		if (end < ext_end)
+		{
+			m_free.emplace(static_cast<u32>(end), static_cast<u32>(ext_end - end));
+			m_free_by_size.emplace(static_cast<u32>(ext_end - end), static_cast<u32>(end));
+		}
+
+		return true;
+	}
+
+	bool block_t::try_alloc(u32 addr, u32 size, u8 flags, u32 sup)
+	{
+		// Check if memory area is already mapped
+		for (u32 i = addr / 4096; i <= (addr + size - 1) / 4096; i++)
+		{
+			if (g_pages[i].flags)
+			{
+				return false;
+			}
+		}
+
+		if (!free_take(addr, size))
+		{
+			return false;
+		}
+
+		// Map "real" memory pages
+		_page_map(addr, size, flags);
+
+		// Add entry
+		m_map[addr] = size;
+		m_used += size;
+
+		// Add supplementary info if necessary
+		if (sup) m_sup[addr] = sup;
+
+		return true;
+	}
+
+	block_t::block_t(u32 addr, u32 size, u64 flags)
+		: addr(addr)
+		, size(size)
+		, flags(flags)
+	{
+		free_insert(addr, size);
+	}
+
+	block_t::~block_t()
+	{
+		writer_lock lock;
+
+		// Deallocate all memory
+		for (auto& entry : m_map)
+		{
+			_page_unmap(entry.first, entry.second);
+		}
+	}
+
+	u32 block_t::alloc(const u32 orig_size, u32 align, const uchar* data, u32 sup)
+	{
+		writer_lock lock;
+
+		// Align to minimal page size
+		const u32 size = ::align(orig_size, 4096);
+
+		// Check alignment (it's page allocation, so passing small values there is just silly)
+		if (align < 4096 || align != (0x80000000u >> cntlz32(align, true)))
+		{
+			fmt::throw_exception("Invalid alignment (size=0x%x, align=0x%x)" HERE, size, align);
+		}
+
+		// Return if size is invalid
+		if (!size || size > this->size)
+		{
+			return 0;
 		}
 
 		u8 pflags = page_readable | page_writable;
@@ -585,17 +1129,19 @@ namespace vm
 			pflags |= page_64k_size;
 		}
 
-		// Search for an appropriate place (unoptimized)
-		for (u32 addr = ::align(this->addr, align); addr < this->addr + this->size - 1; addr += align)
+		// Search for the smallest free extent able to hold the aligned allocation
+		for (auto it = m_free_by_size.lower_bound({size, 0}); it != m_free_by_size.end(); ++it)
 		{
-			if (try_alloc(addr, size, pflags, sup))
+			const u64 addr = ::align<u64>(it->second, align);
+
+			if (addr + size <= u64{it->second} + it->first && try_alloc(static_cast<u32>(addr), size, pflags, sup))
 			{
 				if (data)
 				{
-					std::memcpy(vm::base(addr), data, orig_size);
+					std::memcpy(vm::base(static_cast<u32>(addr)), data, orig_size);
 				}
 
-				return addr;
+				return static_cast<u32>(addr);
 			}
 		}
 
@@ -652,6 +1198,8 @@ namespace vm
 
 			// Remove entry
 			m_map.erase(found);
+			m_used -= size;
+			free_insert(addr, size);
 
 			if (data_out)
 			{
@@ -678,14 +1226,7 @@ namespace vm
 
 	u32 block_t::imp_used(const vm::writer_lock&)
 	{
-		u32 result = 0;
-
-		for (auto& entry : m_map)
-		{
-			result += entry.second;
-		}
-
-		return result;
+		return m_used;
 	}
 
 	u32 block_t::used()
@@ -781,6 +1322,634 @@ namespace vm
 		return nullptr;
 	}
 
+	// Snapshot stream header
+	static const u32 s_snapshot_magic = "VMSS"_u32;
+	static const u32 s_snapshot_version = 2;
+
+	template <typename T>
+	static void _snapshot_put(std::vector<u8>& out, const T& value)
+	{
+		const auto ptr = reinterpret_cast<const u8*>(&value);
+		out.insert(out.end(), ptr, ptr + sizeof(T));
+	}
+
+	// Copy contents of pages (RSX can't change their host protection meanwhile)
+	static void _snapshot_copy(u32 page, u32 count, u8* out)
+	{
+		::reader_lock dirty_lock(g_dirty_mutex);
+		::writer_lock prot_lock(g_dirty_prot_mutex);
+
+		for (u32 i = page; i < page + count; i++, out += 4096)
+		{
+			u8* const ptr = g_base_addr + i * 4096;
+
+			if (~g_pages[i].flags & page_readable)
+			{
+				// Inaccessible page (like a stack guard), contents don't matter
+				std::memset(out, 0, 4096);
+			}
+			else if (static_cast<utils::protection>(g_pages[i].watch.load()) == utils::protection::no)
+			{
+				// Page locked by RSX: unprotect temporarily
+				utils::memory_protect(ptr, 4096, utils::protection::ro);
+				std::memcpy(out, ptr, 4096);
+				utils::memory_protect(ptr, 4096, utils::protection::no);
+			}
+			else
+			{
+				std::memcpy(out, ptr, 4096);
+			}
+		}
+	}
+
+	bool snapshot_save(const fs::file& file)
+	{
+		struct tracked_range
+		{
+			u32 addr;
+			u32 size;
+			u64 epoch;
+		};
+
+		// Blocks tracked by this function (others may be tracked by another user)
+		std::vector<tracked_range> tracked;
+
+		// Pre-copied pages (page -> index in the image + 1)
+		std::vector<u32> image_index(0x100000);
+		std::vector<u8> image;
+
+		// Copy writable pages while the guest is running, tracking writes to them
+		{
+			reader_lock lock;
+
+			std::vector<u32> pages;
+
+			for (const auto& block : g_locations)
+			{
+				if (block && dirty_track(block->addr, block->size))
+				{
+					// Arm all pages
+					pages.clear();
+					tracked.push_back({block->addr, block->size, dirty_collect(block->addr, block->size, 0, pages)});
+				}
+			}
+
+			auto eligible = [](u32 page)
+			{
+				return (g_pages[page].flags & (page_allocated | page_writable)) == (page_allocated | page_writable);
+			};
+
+			u32 count = 0;
+
+			for (const auto& range : tracked)
+			{
+				for (u32 i = range.addr / 4096; i < range.addr / 4096 + range.size / 4096; i++)
+				{
+					count += eligible(i);
+				}
+			}
+
+			image.resize(std::size_t{count} * 4096);
+			count = 0;
+
+			for (const auto& range : tracked)
+			{
+				const u32 end = range.addr / 4096 + range.size / 4096;
+
+				for (u32 i = range.addr / 4096; i < end;)
+				{
+					if (!eligible(i))
+					{
+						i++;
+						continue;
+					}
+
+					// Copy runs of pages up to 1 MiB at once
+					u32 run = 0;
+
+					while (i + run < end && run < 256 && eligible(i + run))
+					{
+						image_index[i + run] = count + run + 1;
+						run++;
+					}
+
+					_snapshot_copy(i, run, image.data() + std::size_t{count} * 4096);
+					count += run;
+					i += run;
+				}
+			}
+		}
+
+		// Layout, page flags (stream start)
+		std::vector<u8> meta;
+
+		// Pages copied with the guest stopped
+		std::vector<u8> fresh;
+
+		// Contents of all allocations in stream order (contiguous chunks are merged)
+		std::vector<std::pair<const u8*, std::size_t>> data;
+
+		{
+			writer_lock lock;
+
+			// Pages written since the pre-copy (or never armed, like read-only ones) must be copied again
+			std::vector<u32> pages;
+
+			for (const auto& range : tracked)
+			{
+				pages.clear();
+				dirty_collect(range.addr, range.size, range.epoch, pages);
+
+				for (u32 addr : pages)
+				{
+					image_index[addr / 4096] = 0;
+				}
+			}
+
+			// Compute sizes first
+			std::size_t meta_size = 12;
+			std::size_t page_count = 0;
+			std::size_t fresh_count = 0;
+
+			for (const auto& block : g_locations)
+			{
+				meta_size += 20;
+
+				if (!block)
+				{
+					continue;
+				}
+
+				for (const auto& entry : block->imp_map(lock))
+				{
+					meta_size += 12 + entry.second / 4096;
+					page_count += entry.second / 4096;
+
+					for (u32 i = entry.first / 4096; i < entry.first / 4096 + entry.second / 4096; i++)
+					{
+						fresh_count += !image_index[i];
+					}
+				}
+			}
+
+			meta.reserve(meta_size);
+			fresh.resize(fresh_count * 4096);
+			data.reserve(page_count);
+			fresh_count = 0;
+
+			auto add_data = [&](const u8* ptr, std::size_t size)
+			{
+				if (!data.empty() && data.back().first + data.back().second == ptr)
+				{
+					data.back().second += size;
+				}
+				else
+				{
+					data.emplace_back(ptr, size);
+				}
+			};
+
+			_snapshot_put(meta, s_snapshot_magic);
+			_snapshot_put(meta, s_snapshot_version);
+			_snapshot_put(meta, ::size32(g_locations));
+
+			for (const auto& block : g_locations)
+			{
+				if (!block)
+				{
+					_snapshot_put(meta, u32{0});
+					_snapshot_put(meta, u32{0});
+					_snapshot_put(meta, u64{0});
+					_snapshot_put(meta, u32{0});
+					continue;
+				}
+
+				const auto& map = block->imp_map(lock);
+
+				_snapshot_put(meta, block->addr);
+				_snapshot_put(meta, block->size);
+				_snapshot_put(meta, block->flags);
+				_snapshot_put(meta, ::size32(map));
+
+				for (const auto& entry : map)
+				{
+					const u32 start = entry.first / 4096;
+					const u32 end = start + entry.second / 4096;
+
+					_snapshot_put(meta, entry.first);
+					_snapshot_put(meta, entry.second);
+					_snapshot_put(meta, block->imp_sup(entry.first, lock));
+
+					for (u32 i = start; i < end; i++)
+					{
+						_snapshot_put(meta, g_pages[i].flags.load());
+					}
+
+					for (u32 i = start; i < end;)
+					{
+						if (const u32 index = image_index[i])
+						{
+							add_data(image.data() + std::size_t{index - 1} * 4096, 4096);
+							i++;
+							continue;
+						}
+
+						u32 run = 0;
+
+						while (i + run < end && !image_index[i + run])
+						{
+							run++;
+						}
+
+						u8* const out = fresh.data() + fresh_count * 4096;
+						_snapshot_copy(i, run, out);
+						add_data(out, std::size_t{run} * 4096);
+						fresh_count += run;
+						i += run;
+					}
+				}
+			}
+		}
+
+		for (const auto& range : tracked)
+		{
+			dirty_untrack(range.addr);
+		}
+
+		z_stream zs{};
+
+		if (deflateInit(&zs, Z_BEST_SPEED) != Z_OK)
+		{
+			return false;
+		}
+
+		std::vector<u8> zout(0x100000);
+
+		// Compress the layout and all chunks as one stream
+		data.emplace(data.begin(), meta.data(), meta.size());
+
+		for (std::size_t index = 0; index < data.size(); index++)
+		{
+			const u8* ptr = data[index].first;
+			std::size_t size = data[index].second;
+
+			do
+			{
+				const uInt chunk = static_cast<uInt>(std::min<std::size_t>(size, 0x1000000));
+				zs.next_in = const_cast<u8*>(ptr);
+				zs.avail_in = chunk;
+				ptr += chunk;
+				size -= chunk;
+
+				const int flush = size == 0 && index + 1 == data.size() ? Z_FINISH : Z_NO_FLUSH;
+				int res;
+
+				do
+				{
+					zs.next_out = zout.data();
+					zs.avail_out = ::size32(zout);
+
+					res = deflate(&zs, flush);
+
+					const u64 out_size = zout.size() - zs.avail_out;
+
+					if (res == Z_STREAM_ERROR || file.write(zout.data(), out_size) != out_size)
+					{
+						LOG_ERROR(MEMORY, "Snapshot write failed");
+						deflateEnd(&zs);
+						return false;
+					}
+				}
+				while (zs.avail_out == 0);
+			}
+			while (size);
+		}
+
+		LOG_NOTICE(MEMORY, "Snapshot saved (%u MiB raw, %u MiB compressed, %u pages copied with the guest stopped)", zs.total_in >> 20, zs.total_out >> 20, fresh.size() / 4096);
+		deflateEnd(&zs);
+		return true;
+	}
+
+	// Streaming decompression of snapshot_save() output
+	class snapshot_reader final
+	{
+		const fs::file& m_file;
+		z_stream m_zs{};
+		std::vector<u8> m_in;
+		std::vector<u8> m_skip;
+		bool m_init = false;
+		bool m_eof = false;
+		bool m_end = false;
+
+	public:
+		snapshot_reader(const fs::file& file)
+			: m_file(file)
+			, m_in(0x100000)
+		{
+			m_init = inflateInit(&m_zs) == Z_OK;
+		}
+
+		snapshot_reader(const snapshot_reader&) = delete;
+
+		~snapshot_reader()
+		{
+			if (m_init)
+			{
+				inflateEnd(&m_zs);
+			}
+		}
+
+		// Decompress exactly `size` bytes (skip them if out is null)
+		bool read(void* out, std::size_t size)
+		{
+			if (!m_init)
+			{
+				return false;
+			}
+
+			u8* dst = static_cast<u8*>(out);
+
+			if (!dst && m_skip.empty())
+			{
+				m_skip.resize(0x100000);
+			}
+
+			while (size)
+			{
+				if (!m_zs.avail_in && !m_eof)
+				{
+					m_zs.next_in = m_in.data();
+					m_zs.avail_in = static_cast<uInt>(m_file.read(m_in.data(), m_in.size()));
+					m_eof = m_zs.avail_in == 0;
+				}
+
+				const uInt chunk = static_cast<uInt>(std::min<std::size_t>(size, dst ? 0x40000000 : m_skip.size()));
+				m_zs.next_out = dst ? dst : m_skip.data();
+				m_zs.avail_out = chunk;
+
+				const int res = m_end ? Z_STREAM_END : inflate(&m_zs, Z_NO_FLUSH);
+				const uInt done = chunk - m_zs.avail_out;
+
+				if (res == Z_STREAM_END)
+				{
+					m_end = true;
+				}
+				else if (res != Z_OK && res != Z_BUF_ERROR)
+				{
+					return false;
+				}
+
+				if (!done && (m_end || m_eof))
+				{
+					return false;
+				}
+
+				size -= done;
+
+				if (dst)
+				{
+					dst += done;
+				}
+			}
+
+			return true;
+		}
+
+		template <typename T>
+		bool get(T& value)
+		{
+			return read(&value, sizeof(T));
+		}
+
+		// Check that the stream ends here
+		bool finish()
+		{
+			u8 extra;
+			return !read(&extra, 1) && m_end;
+		}
+	};
+
+	struct snapshot_alloc
+	{
+		u32 addr;
+		u32 size;
+		u32 sup;
+		std::vector<u8> flags;
+	};
+
+	struct snapshot_block
+	{
+		u32 addr;
+		u32 size;
+		u64 flags;
+		std::vector<snapshot_alloc> allocs;
+	};
+
+	// Read and validate the layout (restoring allocations must not fail after the current blocks are gone)
+	static bool _snapshot_layout(snapshot_reader& in, std::vector<snapshot_block>& blocks)
+	{
+		u32 magic = 0, version = 0, count = 0;
+
+		if (!in.get(magic) || !in.get(version) || !in.get(count) || magic != s_snapshot_magic || version != s_snapshot_version)
+		{
+			LOG_ERROR(MEMORY, "Invalid snapshot header");
+			return false;
+		}
+
+		for (u32 i = 0; i < count; i++)
+		{
+			snapshot_block block;
+			u32 allocs = 0;
+
+			if (!in.get(block.addr) || !in.get(block.size) || !in.get(block.flags) || !in.get(allocs))
+			{
+				LOG_ERROR(MEMORY, "Invalid snapshot block");
+				return false;
+			}
+
+			for (u32 j = 0; j < allocs; j++)
+			{
+				snapshot_alloc alloc;
+
+				if (!in.get(alloc.addr) || !in.get(alloc.size) || !in.get(alloc.sup) || (alloc.size | alloc.addr) % 4096)
+				{
+					LOG_ERROR(MEMORY, "Invalid snapshot allocation (block=0x%x)", block.addr);
+					return false;
+				}
+
+				alloc.flags.resize(alloc.size / 4096);
+
+				if (!in.read(alloc.flags.data(), alloc.flags.size()))
+				{
+					LOG_ERROR(MEMORY, "Invalid snapshot allocation (block=0x%x)", block.addr);
+					return false;
+				}
+
+				block.allocs.emplace_back(std::move(alloc));
+			}
+
+			blocks.emplace_back(std::move(block));
+		}
+
+		std::map<u32, u32> ranges;
+
+		for (const auto& info : blocks)
+		{
+			if (!info.size)
+			{
+				if (!info.allocs.empty())
+				{
+					LOG_ERROR(MEMORY, "Invalid snapshot block (empty, %u allocations)", info.allocs.size());
+					return false;
+				}
+
+				continue;
+			}
+
+			if ((info.addr | info.size) % 4096 || u64{info.addr} + info.size > 0x100000000 || !ranges.emplace(info.addr, info.size).second)
+			{
+				LOG_ERROR(MEMORY, "Invalid snapshot block (addr=0x%x, size=0x%x)", info.addr, info.size);
+				return false;
+			}
+
+			// Allocations are saved in address order
+			u64 next = info.addr;
+
+			for (const auto& alloc : info.allocs)
+			{
+				if (!alloc.size || alloc.addr < next || u64{alloc.addr} + alloc.size > u64{info.addr} + info.size)
+				{
+					LOG_ERROR(MEMORY, "Invalid snapshot allocation (addr=0x%x, size=0x%x, block=0x%x)", alloc.addr, alloc.size, info.addr);
+					return false;
+				}
+
+				next = u64{alloc.addr} + alloc.size;
+			}
+		}
+
+		for (auto it = ranges.begin(); it != ranges.end() && std::next(it) != ranges.end(); it++)
+		{
+			if (u64{it->first} + it->second > std::next(it)->first)
+			{
+				LOG_ERROR(MEMORY, "Overlapping snapshot blocks (0x%x, 0x%x)", it->first, std::next(it)->first);
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool snapshot_load(const fs::file& file)
+	{
+		const u64 start = file.pos();
+
+		// Check the whole stream before destroying current state (contents are skipped)
+		{
+			std::vector<snapshot_block> blocks;
+			snapshot_reader in(file);
+
+			if (!_snapshot_layout(in, blocks))
+			{
+				return false;
+			}
+
+			u64 data_size = 0;
+
+			for (const auto& info : blocks)
+			{
+				for (const auto& alloc : info.allocs)
+				{
+					data_size += alloc.size;
+				}
+			}
+
+			if (!in.read(nullptr, data_size) || !in.finish())
+			{
+				LOG_ERROR(MEMORY, "Snapshot stream is truncated or corrupted");
+				return false;
+			}
+		}
+
+		file.seek(start);
+
+		// Read the layout again, then contents of allocations directly into memory
+		std::vector<snapshot_block> blocks;
+		snapshot_reader in(file);
+
+		if (!_snapshot_layout(in, blocks))
+		{
+			return false;
+		}
+
+		// Create all blocks first (doesn't map anything)
+		std::vector<std::shared_ptr<block_t>> locations;
+
+		for (const auto& info : blocks)
+		{
+			locations.emplace_back(info.size ? std::make_shared<block_t>(info.addr, info.size, info.flags) : nullptr);
+		}
+
+		// Unmap current blocks (destructors take the lock), all pages are free afterwards
+		std::vector<std::shared_ptr<block_t>> old;
+
+		{
+			writer_lock lock(0);
+			old.swap(g_locations);
+		}
+
+		old.clear();
+
+		for (std::size_t index = 0; index < blocks.size(); index++)
+		{
+			const auto& info = blocks[index];
+			const auto& block = locations[index];
+
+			for (const auto& alloc : info.allocs)
+			{
+				if (block->falloc(alloc.addr, alloc.size, nullptr, alloc.sup) != alloc.addr)
+				{
+					// Impossible after validation
+					fmt::throw_exception("Failed to restore allocation (addr=0x%x, size=0x%x)" HERE, alloc.addr, alloc.size);
+				}
+
+				if (!in.read(vm::base(alloc.addr), alloc.size))
+				{
+					// The file was modified after validation
+					fmt::throw_exception("Failed to read allocation contents (addr=0x%x, size=0x%x)" HERE, alloc.addr, alloc.size);
+				}
+
+				writer_lock lock;
+
+				// Restore page flags and host protection
+				for (u32 i = 0; i < alloc.size / 4096; i++)
+				{
+					const u32 addr = alloc.addr + i * 4096;
+					const u8 flags = alloc.flags[i] | page_allocated;
+
+					g_pages[addr / 4096].flags = flags;
+
+					if (flags & page_executable)
+					{
+						utils::memory_commit(g_exec_addr + addr, 4096);
+					}
+
+					if (~flags & page_writable)
+					{
+						utils::memory_protect(g_base_addr + addr, 4096, flags & page_readable ? utils::protection::ro : utils::protection::no);
+					}
+				}
+			}
+		}
+
+		{
+			writer_lock lock(0);
+			g_locations = std::move(locations);
+		}
+
+		LOG_NOTICE(MEMORY, "Snapshot loaded (%u blocks)", blocks.size());
+		return true;
+	}
+
 	namespace ps3
 	{
 		void init()
@@ -795,6 +1964,8 @@ namespace vm
 				std::make_shared<block_t>(0x40000000, 0x10000000), // rsx contexts
 				std::make_shared<block_t>(0x30000000, 0x10000000), // main extend
 			};
+
+			g_huge_pages_failed = false;
 		}
 	}
 
@@ -809,6 +1980,8 @@ namespace vm
 				std::make_shared<block_t>(0xC0000000, 0x10000000), // video (arbitrarily)
 				std::make_shared<block_t>(0xD0000000, 0x10000000), // stack (arbitrarily)
 			};
+
+			g_huge_pages_failed = false;
 		}
 	}
 
@@ -826,11 +1999,30 @@ namespace vm
 				std::make_shared<block_t>(0x00010000, 0x00004000), // scratchpad
 				std::make_shared<block_t>(0x88000000, 0x00800000), // kernel
 			};
+
+			g_huge_pages_failed = false;
 		}
 	}
 
 	void close()
 	{
+		if (const auto stats = get_lock_stats())
+		{
+			LOG_NOTICE(MEMORY, "Writer lock stalls: %u (%u stragglers), total %u us, max %u us", stats.stalls, stats.stragglers, stats.stall_ns / 1000, stats.max_stall_ns / 1000);
+		}
+
+		if (const auto stats = get_waiter_stats())
+		{
+			LOG_NOTICE(MEMORY, "Waiter wakeups: %u (%u spurious)", stats.wakeups, stats.spurious);
+		}
+
+		if (g_cfg.core.huge_pages)
+		{
+			std::size_t resident = 0;
+			const std::size_t huge = utils::memory_huge_usage(g_base_addr, 0x100000000, &resident);
+			LOG_NOTICE(MEMORY, "Huge pages: %u MiB of %u MiB resident guest memory", huge >> 20, resident >> 20);
+		}
+
 		g_locations.clear();
 
 		utils::memory_decommit(g_base_addr, 0x100000000);
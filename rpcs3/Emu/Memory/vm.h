@@ -1,12 +1,23 @@
 #pragma once
 
 #include <map>
+#include <set>
 #include <functional>
 #include <memory>
 
 class named_thread;
 class cpu_thread;
 
+namespace fs
+{
+	class file;
+}
+
+namespace utils
+{
+	enum class protection;
+}
+
 namespace vm
 {
 	extern u8* const g_base_addr;
@@ -45,17 +56,33 @@ namespace vm
 		u32 size;
 		u64 stamp;
 		const void* data;
+		bool linked = false;
 
 		waiter() = default;
 
 		waiter(const waiter&) = delete;
 
 		void init();
-		void test() const;
+
+		// Notify the owner if the data has changed, return true if notified
+		bool test() const;
+
+		// Count wakeup which didn't bring the awaited change
+		static void count_spurious();
 
 		~waiter();
 	};
 
+	struct waiter_stats
+	{
+		u64 wakeups = 0; // Owners notified by notify()
+		u64 spurious = 0; // Owners woken up without the awaited change
+
+		explicit operator bool() const { return wakeups || spurious; }
+	};
+
+	waiter_stats get_waiter_stats();
+
 	// Address type
 	enum addr_t : u32 {};
 
@@ -100,6 +127,19 @@ namespace vm
 		explicit operator bool() const { return locked; }
 	};
 
+	// Time spent by full writer locks waiting for passive readers
+	struct lock_stats
+	{
+		u64 stalls = 0; // Writer locks that had to wait
+		u64 stall_ns = 0; // Total wait time
+		u64 max_stall_ns = 0; // Longest wait time
+		u64 stragglers = 0; // Passive readers waited for
+
+		explicit operator bool() const { return stalls != 0; }
+	};
+
+	lock_stats get_lock_stats();
+
 	// Get reservation status for further atomic update: last update timestamp
 	u64 reservation_acquire(u32 addr, u32 size);
 
@@ -118,6 +158,34 @@ namespace vm
 	// Check flags for specified memory range (unsafe)
 	bool check_addr(u32 addr, u32 size = 1, u8 flags = page_allocated);
 
+	// Start tracking writes to the range (page aligned), return false if it overlaps a tracked range.
+	// Armed pages are read-only on the host: the host OS can't write there (EFAULT), see dirty_host_write.
+	bool dirty_track(u32 addr, u32 size);
+
+	// Stop tracking writes to the range started at addr
+	void dirty_untrack(u32 addr);
+
+	// Get tracked pages written since the epoch and re-arm them, return the epoch to pass next time (0 gets all pages)
+	u64 dirty_collect(u32 addr, u32 size, u64 since, std::vector<u32>& pages);
+
+	// Handle write fault on a tracked page (internal)
+	bool dirty_fault(u32 addr);
+
+	// Unarm tracked pages in range and don't re-arm any pages while alive (wrap host OS writes to guest memory, like recv())
+	class dirty_host_write final
+	{
+	public:
+		dirty_host_write(u32 addr = 0, u32 size = 0);
+		dirty_host_write(const dirty_host_write&) = delete;
+		~dirty_host_write();
+
+		// Unarm another range
+		void add(u32 addr, u32 size);
+	};
+
+	// Change host protection of the range (page aligned) for access watching (RSX texture cache), cooperates with dirty tracking
+	void host_protect(u32 addr, u32 size, utils::protection prot);
+
 	// Search and map memory in specified memory location (don't pass alignment smaller than 4096)
 	u32 alloc(u32 size, memory_location_t location, u32 align = 4096, u32 sup = 0);
 
@@ -135,9 +203,18 @@ namespace vm
 	{
 		std::map<u32, u32> m_map; // Mapped memory: addr -> size
 		std::unordered_map<u32, u32> m_sup; // Supplementary info for allocations
+		std::map<u32, u32> m_free; // Free extents: addr -> size
+		std::set<std::pair<u32, u32>> m_free_by_size; // Free extents: (size, addr)
+		u32 m_used = 0; // Allocated memory count
 
 		bool try_alloc(u32 addr, u32 size, u8 flags, u32 sup);
 
+		// Add free extent, merging it with adjacent ones
+		void free_insert(u32 addr, u32 size);
+
+		// Remove range from the free extent containing it, return false if the range isn't free
+		bool free_take(u32 addr, u32 size);
+
 	public:
 		block_t(u32 addr, u32 size, u64 flags = 0);
 
@@ -160,6 +237,19 @@ namespace vm
 		// Internal
 		u32 imp_used(const vm::writer_lock&);
 
+		// Internal: get allocations (addr -> size)
+		const std::map<u32, u32>& imp_map(const vm::writer_lock&) const
+		{
+			return m_map;
+		}
+
+		// Internal: get supplementary info for allocation
+		u32 imp_sup(u32 addr, const vm::writer_lock&) const
+		{
+			const auto found = m_sup.find(addr);
+			return found == m_sup.end() ? 0 : found->second;
+		}
+
 		// Get allocated memory count
 		u32 used();
 	};
@@ -173,6 +263,13 @@ namespace vm
 	// Get memory block associated with optionally specified memory location or optionally specified address
 	std::shared_ptr<block_t> get(memory_location_t location, u32 addr = 0);
 
+	// Save memory blocks, allocations, page flags and contents into a compressed stream.
+	// Writable pages are pre-copied while the guest runs (dirty tracked), only pages written meanwhile are copied with it stopped.
+	bool snapshot_save(const fs::file& file);
+
+	// Replace all memory blocks with ones saved by snapshot_save() (CPU threads must be paused)
+	bool snapshot_load(const fs::file& file);
+
 	// Get PS3/PSV virtual memory address from the provided pointer (nullptr always converted to 0)
 	inline vm::addr_t get_addr(const void* real_ptr)
 	{
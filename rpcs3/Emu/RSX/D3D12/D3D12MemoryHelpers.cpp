@@ -19,7 +19,7 @@ void data_cache::protect_data(u64 key, u32 start, size_t size)
 	u32 protected_range_start = start & ~(memory_page_size - 1);
 	u32 protected_range_size = (u32)align(size, memory_page_size);
 	m_protected_ranges.push_back(std::make_tuple(key, protected_range_start, protected_range_size));
-	utils::memory_protect(vm::base(protected_range_start), protected_range_size, utils::protection::ro);
+	vm::host_protect(protected_range_start, protected_range_size, utils::protection::ro);
 }
 
 bool data_cache::invalidate_address(u32 addr)
@@ -39,7 +39,7 @@ bool data_cache::invalidate_address(u32 addr)
 			u64 texadrr = std::get<0>(protectedTexture);
 			m_address_to_data[texadrr].first.m_is_dirty = true;
 
-			utils::memory_protect(vm::base(protectedRangeStart), protectedRangeSize, utils::protection::rw);
+			vm::host_protect(protectedRangeStart, protectedRangeSize, utils::protection::rw);
 			m_protected_ranges.erase(currentIt);
 			handled = true;
 		}
@@ -62,7 +62,7 @@ void data_cache::unprotect_all()
 	for (auto &protectedTexture : m_protected_ranges)
 	{
 		u32 protectedRangeStart = std::get<1>(protectedTexture), protectedRangeSize = std::get<2>(protectedTexture);
-		utils::memory_protect(vm::base(protectedRangeStart), protectedRangeSize, utils::protection::rw);
+		vm::host_protect(protectedRangeStart, protectedRangeSize, utils::protection::rw);
 	}
 }
 
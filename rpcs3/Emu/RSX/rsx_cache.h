@@ -124,7 +124,7 @@ namespace rsx
 		{
 			if (prot == protection) return;
 
-			utils::memory_protect(vm::base(locked_address_base), locked_address_range, prot);
+			vm::host_protect(locked_address_base, locked_address_range, prot);
 			protection = prot;
 			locked = prot != utils::protection::rw;
 		}
@@ -957,6 +957,10 @@ void Emulator::Stop(bool restart)
 		on_select(0, *mfc);
 	}
 
+	// Wake up idle service threads
+	extern void lv2_fs_prefetch_stop();
+	lv2_fs_prefetch_stop();
+
 	LOG_NOTICE(GENERAL, "All threads signaled...");
 
 	while (g_thread_count)
@@ -968,6 +972,12 @@ void Emulator::Stop(bool restart)
 
 	LOG_NOTICE(GENERAL, "All threads stopped...");
 
+	if (g_cfg.core.ppu_histogram)
+	{
+		extern void ppu_histogram_report();
+		ppu_histogram_report();
+	}
+
 	lv2_obj::cleanup();
 	idm::clear();
 	fxm::clear();
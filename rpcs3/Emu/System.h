@@ -283,6 +283,8 @@ struct cfg_root : cfg::node
 		cfg::_enum<ppu_decoder_type> ppu_decoder{this, "PPU Decoder", ppu_decoder_type::llvm};
 		cfg::_int<1, 16> ppu_threads{this, "PPU Threads", 2}; // Amount of PPU threads running simultaneously (must be 2)
 		cfg::_bool ppu_debug{this, "PPU Debug"};
+		cfg::_bool ppu_histogram{this, "PPU Instruction Histogram"}; // Count executed instructions and write a report on stop
+		cfg::_bool huge_pages{this, "Use huge pages for guest memory"}; // Back large guest allocations with 2 MiB host pages
 		cfg::_bool llvm_logs{this, "Save LLVM logs"};
 		cfg::string llvm_cpu{this, "Use LLVM CPU"};
 		cfg::_int<0, INT32_MAX> llvm_threads{this, "Max LLVM Compile Threads", 0};
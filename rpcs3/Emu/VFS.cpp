@@ -10,6 +10,34 @@ struct vfs_manager
 
 	// Device name -> Real path
 	std::unordered_map<std::string, std::string> mounted;
+
+	struct resolved
+	{
+		std::string path; // Host path (may be case-corrected)
+		bool missing; // Cached negative stat result
+	};
+
+	// PS3 path -> Resolved path (bounded, flushed on overflow)
+	std::unordered_map<std::string, resolved> cache;
+
+	// Host directory -> (lowercase name -> name), for case-insensitive lookup (bounded, flushed on overflow)
+	std::unordered_map<std::string, std::unordered_map<std::string, std::string>> listings;
+
+	// Incremented on every mount and invalidation to discard stale results computed without the lock
+	u64 generation = 0;
+
+	static constexpr std::size_t cache_max = 4096;
+	static constexpr std::size_t listings_max = 256;
+
+	void cache_put(const std::string& vpath, const std::string& path, bool missing)
+	{
+		if (cache.size() >= cache_max)
+		{
+			cache.clear();
+		}
+
+		cache[vpath] = {path, missing};
+	}
 };
 
 const std::regex s_regex_ps3("^/+(.*?)(?:$|/)(.*)", std::regex::optimize);
@@ -21,22 +49,23 @@ bool vfs::mount(const std::string& dev_name, const std::string& path)
 
 	writer_lock lock(table->mutex);
 
+	table->cache.clear();
+	table->listings.clear();
+	table->generation++;
+
 	return table->mounted.emplace(dev_name, path).second;
 }
 
-std::string vfs::get(const std::string& vpath, vfs::type _type)
+// Resolve VFS path (table mutex must be locked); optionally returns device root and relative part
+static std::string vfs_resolve(const vfs_manager& table, const std::string& vpath, vfs::type _type, std::string* root = nullptr, std::string* rest = nullptr)
 {
-	const auto table = fxm::get_always<vfs_manager>();
-
-	reader_lock lock(table->mutex);
-
 	std::smatch match;
 
-	if (!std::regex_match(vpath, match, _type == type::ps3 ? s_regex_ps3 : s_regex_psv))
+	if (!std::regex_match(vpath, match, _type == vfs::type::ps3 ? s_regex_ps3 : s_regex_psv))
 	{
-		const auto found = table->mounted.find("");
+		const auto found = table.mounted.find("");
 
-		if (found == table->mounted.end())
+		if (found == table.mounted.end())
 		{
 			LOG_WARNING(GENERAL, "vfs::get(): no default directory: %s", vpath);
 			return {};
@@ -45,14 +74,14 @@ std::string vfs::get(const std::string& vpath, vfs::type _type)
 		return found->second + vfs::escape(vpath);
 	}
 
-	if (_type == type::ps3 && match.length(1) == 0)
+	if (_type == vfs::type::ps3 && match.length(1) == 0)
 	{
 		return "/";
 	}
 
-	const auto found = table->mounted.find(match.str(1));
+	const auto found = table.mounted.find(match.str(1));
 
-	if (found == table->mounted.end())
+	if (found == table.mounted.end())
 	{
 		LOG_WARNING(GENERAL, "vfs::get(): device not found: %s", vpath);
 		return {};
@@ -64,10 +93,324 @@ std::string vfs::get(const std::string& vpath, vfs::type _type)
 		return match.str(2);
 	}
 
+	if (root && rest)
+	{
+		*root = found->second;
+		*rest = vfs::escape(match.str(2));
+		return *root + *rest;
+	}
+
 	// Escape and concatenate
 	return found->second + vfs::escape(match.str(2));
 }
 
+std::string vfs::get(const std::string& vpath, vfs::type _type)
+{
+	const auto table = fxm::get_always<vfs_manager>();
+
+	if (_type != type::ps3)
+	{
+		reader_lock lock(table->mutex);
+
+		return vfs_resolve(*table, vpath, _type);
+	}
+
+	std::string result;
+	u64 generation;
+
+	{
+		reader_lock lock(table->mutex);
+
+		const auto found = table->cache.find(vpath);
+
+		if (found != table->cache.end())
+		{
+			return found->second.path;
+		}
+
+		result = vfs_resolve(*table, vpath, _type);
+		generation = table->generation;
+	}
+
+	if (!result.empty() && result != "/")
+	{
+		writer_lock lock(table->mutex);
+
+		if (table->generation == generation)
+		{
+			table->cache_put(vpath, result, false);
+		}
+	}
+
+	return result;
+}
+
+// Paths for which case-insensitive lookup is attempted (game data)
+static bool vfs_is_game_data(const std::string& vpath)
+{
+	return vpath.compare(0, 10, "/dev_bdvd/") == 0 || vpath.compare(0, 15, "/dev_hdd0/game/") == 0;
+}
+
+// Paths for which misses and directory listings are cached: HLE modules write /dev_hdd0 with fs:: directly, bypassing vfs::invalidate
+static bool vfs_is_read_only(const std::string& vpath)
+{
+	return vpath.compare(0, 10, "/dev_bdvd/") == 0;
+}
+
+static std::string vfs_lower(const std::string& name)
+{
+	std::string result(name);
+
+	for (char& c : result)
+	{
+		c = static_cast<char>(std::tolower(static_cast<uchar>(c)));
+	}
+
+	return result;
+}
+
+// Check if host path is equal to base or is located below it, ignoring ASCII case and trailing slashes
+static bool vfs_host_match(const std::string& path, const std::string& base)
+{
+	std::size_t len = base.size();
+
+	while (len && base[len - 1] == '/')
+	{
+		len--;
+	}
+
+	if (path.size() < len || vfs_lower(path.substr(0, len)) != vfs_lower(base.substr(0, len)))
+	{
+		return false;
+	}
+
+	return path.find_first_not_of('/', len) == std::string::npos || path[len] == '/';
+}
+
+#ifndef _WIN32
+// Find directory entry ignoring ASCII case, optionally using cached directory listing
+static bool vfs_find_folded(vfs_manager& table, const std::string& dir, const std::string& name, std::string& out, bool cache)
+{
+	const std::string key = vfs_lower(name);
+
+	u64 generation = 0;
+
+	if (cache)
+	{
+		reader_lock lock(table.mutex);
+
+		const auto found = table.listings.find(dir);
+
+		if (found != table.listings.end())
+		{
+			const auto entry = found->second.find(key);
+
+			if (entry == found->second.end())
+			{
+				return false;
+			}
+
+			out = entry->second;
+			return true;
+		}
+
+		generation = table.generation;
+	}
+
+	std::unordered_map<std::string, std::string> names;
+
+	for (const auto& entry : fs::dir(dir))
+	{
+		names.emplace(vfs_lower(entry.name), entry.name);
+	}
+
+	const auto entry = names.find(key);
+	const bool result = entry != names.end();
+
+	if (result)
+	{
+		out = entry->second;
+	}
+
+	if (!cache)
+	{
+		return result;
+	}
+
+	writer_lock lock(table.mutex);
+
+	if (table.generation == generation)
+	{
+		if (table.listings.size() >= vfs_manager::listings_max)
+		{
+			table.listings.clear();
+		}
+
+		table.listings.emplace(dir, std::move(names));
+	}
+
+	return result;
+}
+
+// Find existing path ignoring ASCII case of each component of rest
+static bool vfs_fold_case(vfs_manager& table, std::string path, const std::string& rest, std::string& out, bool cache)
+{
+	for (std::size_t pos = 0; pos < rest.size();)
+	{
+		const std::size_t end = std::min(rest.find_first_of('/', pos), rest.size());
+		const std::string name = rest.substr(pos, end - pos);
+		pos = end + 1;
+
+		if (name.empty() || name == "." || name == "..")
+		{
+			if (!name.empty()) path += name + '/';
+			continue;
+		}
+
+		if (!fs::exists(path + name))
+		{
+			std::string real;
+
+			if (!vfs_find_folded(table, path, name, real, cache))
+			{
+				return false;
+			}
+
+			path += real;
+		}
+		else
+		{
+			path += name;
+		}
+
+		if (pos < rest.size())
+		{
+			path += '/';
+		}
+	}
+
+	out = std::move(path);
+	return true;
+}
+#endif
+
+bool vfs::stat(const std::string& vpath, std::string& local_path, fs::stat_t& info)
+{
+	const auto table = fxm::get_always<vfs_manager>();
+
+	u64 generation;
+
+	{
+		reader_lock lock(table->mutex);
+
+		const auto found = table->cache.find(vpath);
+
+		if (found != table->cache.end() && found->second.missing)
+		{
+			fs::g_tls_error = fs::error::noent;
+			return false;
+		}
+
+		generation = table->generation;
+	}
+
+	if (fs::stat(local_path, info))
+	{
+		return true;
+	}
+
+	if (fs::g_tls_error != fs::error::noent || !vfs_is_game_data(vpath))
+	{
+		return false;
+	}
+
+#ifndef _WIN32
+	// Retry ignoring case (game data is often dumped from case-insensitive file systems)
+	std::string root, rest, fixed;
+
+	{
+		reader_lock lock(table->mutex);
+
+		vfs_resolve(*table, vpath, type::ps3, &root, &rest);
+	}
+
+	const bool cache = vfs_is_read_only(vpath);
+
+	if (!root.empty() && vfs_fold_case(*table, root, rest, fixed, cache) && fs::stat(fixed, info))
+	{
+		writer_lock lock(table->mutex);
+
+		if (cache && table->generation == generation)
+		{
+			table->cache_put(vpath, fixed, false);
+		}
+
+		local_path = std::move(fixed);
+		return true;
+	}
+#endif
+
+	// Remember the miss on read-only media
+	if (vfs_is_read_only(vpath))
+	{
+		writer_lock lock(table->mutex);
+
+		if (table->generation == generation)
+		{
+			table->cache_put(vpath, local_path, true);
+		}
+	}
+
+	fs::g_tls_error = fs::error::noent;
+	return false;
+}
+
+void vfs::invalidate(const std::string& vpath)
+{
+	if (vpath.empty())
+	{
+		return;
+	}
+
+	const auto table = fxm::get_always<vfs_manager>();
+
+	writer_lock lock(table->mutex);
+
+	table->generation++;
+
+	// Other PS3 paths may point to the same host path (/app_home, /host_root), so match host paths as well
+	const std::string path = vfs_resolve(*table, vpath, type::ps3);
+	const std::string parent = path.substr(0, path.find_last_of('/', path.find_last_not_of('/')));
+
+	// Erase the path itself and everything below it
+	for (auto it = table->cache.begin(); it != table->cache.end();)
+	{
+		const std::string& key = it->first;
+
+		if ((key.compare(0, vpath.size(), vpath) == 0 && (key.size() == vpath.size() || key[vpath.size()] == '/' || vpath.back() == '/')) ||
+			(!path.empty() && vfs_host_match(it->second.path, path)))
+		{
+			it = table->cache.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+
+	// Erase directory listings: the parent directory and everything below the path
+	for (auto it = table->listings.begin(); it != table->listings.end();)
+	{
+		if (!path.empty() && (vfs_host_match(it->first, path) || (vfs_host_match(it->first, parent) && vfs_host_match(parent, it->first))))
+		{
+			it = table->listings.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+}
 
 std::string vfs::escape(const std::string& path)
 {
@@ -2,6 +2,11 @@
 
 #include <string>
 
+namespace fs
+{
+	struct stat_t;
+}
+
 namespace vfs
 {
 	// VFS type
@@ -17,6 +22,12 @@ namespace vfs
 	// Convert VFS path to fs path
 	std::string get(const std::string& vpath, type _type = type::ps3);
 
+	// Stat file at PS3 path previously resolved by get(), using cached negative results and case-insensitive fallback (may update local_path)
+	bool stat(const std::string& vpath, std::string& local_path, fs::stat_t& info);
+
+	// Drop cached resolutions of PS3 path and everything below it (must be called after it's created, renamed or removed)
+	void invalidate(const std::string& vpath);
+
 	// Escape VFS path by replacing non-portable characters with surrogates
 	std::string escape(const std::string& path);
 